@@ -0,0 +1,33 @@
+; Batch evaluation of data files with the cpad_udf_library (vof_droplet_detection.c)
+;
+; Read the case and load the compiled library once, then load this file and
+; evaluate a list of data files in one session:
+;
+;   (load "cpad_batch.scm")
+;   (cpad-batch '("run-0.02.dat" "run-0.04.dat" "run-0.06.dat"))
+;
+; The list can be generated with example/postprocess/write_eval_scheme.py.
+; Every data file is read into the loaded case and evaluated with
+; CPAD_BATCH_oD, the cached neighbor graph of the mesh is reused for all
+; files. The results of all files are appended to the usual result files
+; (one record per file), cpa_batch.csv holds index, file name, flow time,
+; number of global cpas and timings of every file.
+
+(define (cpad-define-var name default type)
+  (if (not (rp-var-object name))
+      (rp-var-define name default type #f)))
+
+(cpad-define-var 'cpad/batch-index 0 'int)         ; index of the current file
+(cpad-define-var 'cpad/batch-file "" 'string)      ; name of the current file
+
+(define (cpad-batch files)
+  (let loop ((fs files) (i 0))
+    (if (pair? fs)
+        (begin
+          ; "ok" confirms discarding the modified data of the previous file
+          (ti-menu-load-string (string-append "/file/read-data \"" (car fs) "\" ok"))
+          (rpsetvar 'cpad/batch-index i)
+          (rpsetvar 'cpad/batch-file (car fs))
+          (ti-menu-load-string
+            "/define/user-defined/execute-on-demand \"CPAD_BATCH_oD::libudf\"")
+          (loop (cdr fs) (+ i 1))))))
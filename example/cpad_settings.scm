@@ -0,0 +1,34 @@
+; Runtime settings of the cpad_udf_library (vof_droplet_detection.c)
+;
+; Load once per Fluent session (File > Read > Scheme... or in a journal:
+; (load "cpad_settings.scm")). The library reads the variables at every
+; detection call, undefined variables fall back to the defaults compiled into
+; the library (_PHASE_IDX, _MIN_VOL_FRAC, _CONNECTIVITY, _FLUID_).
+;
+; Change a setting between two calls, e.g. in a journal:
+;   (rpsetvar 'cpad/min-vol-frac 0.05)
+;   /define/user-defined/execute-on-demand "CPAD_oD::libudf"
+
+(define (cpad-define-var name default type)
+  (if (not (rp-var-object name))
+      (rp-var-define name default type #f)))
+
+(cpad-define-var 'cpad/phases '(0) 'list)         ; phase indices, several phases: one file per phase
+(cpad-define-var 'cpad/min-vol-frac 0.01 'real)   ; lower limit of the volume fraction
+; (cpad-define-var 'cpad/min-vol-fracs '(0.01 0.05 0.1 0.5) 'list)  ; several limits in one pass, one file per limit
+(cpad-define-var 'cpad/connectivity 0 'int)       ; 0: faces, 1: edges, 2: vertices
+(cpad-define-var 'cpad/fluid-zones '(1) 'list)    ; fluid cell zone ids
+; (cpad-define-var 'cpad/label-udm 0 'int)       ; UDM for the cpa label of every cell, -1: off
+
+; Threshold sweep on the loaded data set in one pass:
+;
+; (rpsetvar 'cpad/min-vol-fracs '(0.01 0.05 0.1 0.5))
+;
+; or one call per threshold (results of every call are appended
+; to the cpa files, the time value is the same for all thresholds):
+;
+; (for-each
+;   (lambda (limit)
+;     (rpsetvar 'cpad/min-vol-frac limit)
+;     (ti-menu-load-string "/define/user-defined/execute-on-demand \"CPAD_oD::libudf\""))
+;   '(0.01 0.05 0.1 0.5))
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""
+Reader for the binary cpa files (<myid>_cpa.bin, cpa_global.bin) written by
+the cpad_udf_library with _OUTPUT CPA_OUTPUT_BINARY and converter to the text
+format (<myid>_cpa.txt, cpa_global.txt), see writeCpasBinary() in
+vof_droplet_detection.c for the record layout.
+
+Usage:
+    python cpa_bin2txt.py 0_cpa.bin [1_cpa.bin ...]   -> 0_cpa.txt ...
+    python cpa_bin2txt.py cpa_global.bin -o out.txt
+"""
+
+import struct
+import sys
+from os.path import splitext
+
+HEADER_BYTES = 48
+SUPPORTED_VERSIONS = (1,)
+
+TEXT_HEADER = ("cell_count[com.(x)_in_m,com.(y),com.(z),mass_in_kg,"
+               "volume_in_m³,cellAveragedAlpha,maxAlpha,"
+               "[list_of_boundary_names],[list_of_processor_cells]]")
+GLOBAL_TEXT_HEADER = ("global_id,cell_count[com.(x)_in_m,com.(y),com.(z),mass_in_kg,"
+                      "volume_in_m³,cellAveragedAlpha,maxAlpha,"
+                      "[list_of_boundary_names],no_of_partition_fragments]")
+
+
+def _lists(offsets, values, n):
+    return [values[offsets[i]:offsets[i + 1]] for i in range(n)]
+
+
+def read_cpa_bin(path):
+    """Yield one dict per record (detection call) of a binary cpa file."""
+    with open(path, "rb") as f:
+        data = f.read()
+
+    pos = 0
+    while pos + HEADER_BYTES <= len(data):
+        magic = data[pos:pos + 4]
+        if magic != b"CPAD":
+            raise ValueError("%s: no cpa record at byte %i" % (path, pos))
+
+        version, size, nd = struct.unpack_from("=3i", data, pos + 4)
+        if version not in SUPPORTED_VERSIONS:
+            raise ValueError("%s: unsupported record version %i" % (path, version))
+
+        (time,) = struct.unpack_from("=d", data, pos + 16)
+        rank, n, nb, nf, nr = struct.unpack_from("=5i", data, pos + 24)
+
+        p = pos + HEADER_BYTES
+        reals = struct.unpack_from("=%id" % ((nd + 4) * n), data, p)
+        p += 8 * (nd + 4) * n
+        ints = struct.unpack_from("=%ii" % (6 * n + 3 + nb + nf + nr), data, p)
+
+        com = [reals[j * n:(j + 1) * n] for j in range(nd)]
+        b_off = ints[3 * n:4 * n + 1]
+        f_off = ints[4 * n + 1:5 * n + 2]
+        r_off = ints[5 * n + 2:6 * n + 3]
+        lists = ints[6 * n + 3:]
+
+        yield {
+            "time": time,
+            "rank": rank,
+            "no_cells": ints[0:n],
+            "global_id": ints[n:2 * n],
+            "no_fragments": ints[2 * n:3 * n],
+            "com": [tuple(com[j][i] for j in range(nd)) for i in range(n)],
+            "mass": reals[nd * n:(nd + 1) * n],
+            "vol": reals[(nd + 1) * n:(nd + 2) * n],
+            "alpha_mean": reals[(nd + 2) * n:(nd + 3) * n],
+            "alpha_max": reals[(nd + 3) * n:(nd + 4) * n],
+            "boundaries": _lists(b_off, lists[0:nb], n),
+            "faces": _lists(f_off, lists[nb:nb + nf], n),
+            "ranks": _lists(r_off, lists[nb + nf:], n),
+        }
+
+        pos += size
+
+
+def record_to_text(r):
+    """Format a record like printCpas() / printGlobalCpas()."""
+    out = ["{", "%f" % r["time"]]
+    out.append(GLOBAL_TEXT_HEADER if r["rank"] < 0 else TEXT_HEADER)
+
+    for i in range(len(r["no_cells"])):
+        line = "%i[" % r["no_cells"][i]
+        if r["rank"] < 0:
+            line = "%i," % r["global_id"][i] + line
+        line += "".join(" %f," % x for x in r["com"][i])
+        line += "%E,%E,%E,%E," % (r["mass"][i], r["vol"][i],
+                                  r["alpha_mean"][i], r["alpha_max"][i])
+
+        names = ["%i" % b for b in r["boundaries"][i]]
+        if r["rank"] < 0:
+            line += "[" + ",".join(names) + "],%i]" % r["no_fragments"][i]
+        else:
+            names += ["procBoundary%ito%i" % (r["rank"], k) for k in r["ranks"][i]]
+            faces = r["faces"][i]
+            line += "[" + ",".join(names) + "],"
+            line += "%i[" % len(faces) + ",".join("%i" % f for f in faces) + "]]"
+        out.append(line)
+
+    out.append("}")
+    return "\n".join(out) + "\n"
+
+
+def convert(path, out_path=None):
+    if out_path is None:
+        out_path = splitext(path)[0] + ".txt"
+
+    with open(out_path, "w", encoding="utf-8") as f:
+        for r in read_cpa_bin(path):
+            f.write(record_to_text(r))
+
+    return out_path
+
+
+if __name__ == "__main__":
+    args = sys.argv[1:]
+    out = None
+
+    if "-o" in args:
+        k = args.index("-o")
+        out = args[k + 1]
+        del args[k:k + 2]
+
+    if not args or (out is not None and len(args) > 1):
+        print(__doc__)
+        sys.exit(1)
+
+    for fn in args:
+        print(convert(fn, out))
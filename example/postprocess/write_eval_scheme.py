@@ -1,14 +1,20 @@
 #!/usr/bin/env python3
 
-from os import listdir
-from os.path import isfile, join
+import sys
+from glob import glob
+from os.path import join
 
-mypath="F:\\myfolder"
-onlyfiles = [f for f in listdir(mypath) if isfile(join(mypath, f))]
+# usage: write_eval_scheme.py [folder] [pattern] > cpad_pp.jou
+mypath = sys.argv[1] if len(sys.argv) > 1 else "F:\\myfolder"
+pattern = sys.argv[2] if len(sys.argv) > 2 else "*.dat"
+
+onlyfiles = sorted(glob(join(mypath, pattern)))
+
+# all files are evaluated in one batch (CPAD_BATCH_oD, see ../cpad_batch.scm)
+print("(load \"cpad_batch.scm\")")
+print("(cpad-batch '(")
 
 for fn in onlyfiles:
-    if fn.endswith(".dat"):
-         print("file/read-data/"+fn)
-         print("ok")
-         print("")
-         print("/define/user-defined/execute-on-demand","\"CPAD_oD::libudf\"")
+    print("  \"" + fn.replace("\\", "\\\\") + "\"")
+
+print("))")
@@ -0,0 +1,388 @@
+/*
+Benchmark of the cpad UDF library on synthetic VOF fields and growing meshes.
+
+For every mesh size, field and labelling engine the detection is run once to
+build the cached neighbor graph and then -r times; the per phase wall clock
+times measured inside the library (cpa_timings) are averaged over these runs.
+
+Usage:
+    cpad_bench [-m hex|tet|poly] [-c cells,...] [-f fields] [-e flood,uf,inc]
+               [-r repeats] [-o file.csv]
+
+    -m  mesh type (default hex)
+    -c  comma separated approximate cell counts (default 1e4,1e5,1e6), the
+        mesh is a cube with round(cells^(1/3)) hexes per direction (tet: 6
+        cells per hex)
+    -f  comma separated fields (default droplets,sheet,ligaments,noise)
+            droplets  : regular lattice of tiny droplets (r = 1.5 cells)
+            sheet     : one liquid layer filling half of the domain
+            ligaments : network of thin liquid threads (single large cpa)
+            noise     : pseudo random alpha around _MIN_VOL_FRAC
+    -e  comma separated labelling engines (default flood,uf), inc: incremental
+        labelling, the timed runs only update the labels (unchanged field)
+    -r  number of timed runs per case (default 3)
+    -o  also write the results as csv
+
+Result files of the library are written to the working directory and
+removed after every case.
+ */
+
+#include <sys/resource.h>
+#include "udf.h"
+#include "sa_mesh.h"
+
+#define BENCH_MAX_ITEMS 16
+
+struct CpaTimings   /* see vof_droplet_detection.c */
+{
+    double  counting;
+    double  adjacency;
+    double  labelling;
+    double  reduction;
+    double  stitching;
+    double  output;
+    double  total;
+    int     no_cells;
+    int     no_labelled_cells;
+    int     no_cpas;
+    long    no_nb_lookups;
+    long    no_boundary_updates;
+    size_t  arena_bytes;
+};
+
+extern struct CpaTimings cpa_timings;
+
+void CPAD_aE(void);
+void CPAD_aX(void);
+void CPAD_FLOOD_FILL_oD(void);
+void CPAD_UNION_FIND_oD(void);
+void CPAD_INCREMENTAL_oD(void);
+void CPAD_RESET_oD(void);
+
+struct BenchField
+{
+    const char *name;
+    real (*alpha)(const real x[ND_ND], void *ctx);
+};
+
+struct BenchCtx
+{
+    real h;                             /* cell size */
+};
+
+/* ------------------------------------------------------------------------- */
+/* fields (unit cube) */
+
+static real dropletsField(const real x[ND_ND], void *ctx)
+{
+    real h = ((struct BenchCtx*) ctx)->h;
+    real spacing = 6*h;
+    real r2 = 0;
+    int k;
+
+    for(k = 0; k < 3; ++k)
+    {
+        real dx = fmod(x[k], spacing) - 0.5*spacing;
+        r2 += dx*dx;
+    }
+
+    return (r2 < 2.25*h*h) ? 1.0 : 0.0;
+}
+
+
+static real sheetField(const real x[ND_ND], void *ctx)
+{
+    return (x[2] < 0.5) ? 0.9 : 0.0;
+}
+
+
+static real ligamentsField(const real x[ND_ND], void *ctx)
+{
+    real h = ((struct BenchCtx*) ctx)->h;
+    real spacing = 0.125;
+    real d[3], r = 1.5*h;
+    int k;
+
+    for(k = 0; k < 3; ++k)
+    {
+        d[k] = fmod(x[k], spacing) - 0.5*spacing;
+    }
+
+    /* threads along x, y and z through the lattice points */
+    if(d[1]*d[1] + d[2]*d[2] < r*r || d[0]*d[0] + d[2]*d[2] < r*r
+       || d[0]*d[0] + d[1]*d[1] < r*r)
+    {
+        return 1.0;
+    }
+
+    return 0.0;
+}
+
+
+static real noiseField(const real x[ND_ND], void *ctx)
+{
+    real h = ((struct BenchCtx*) ctx)->h;
+    unsigned long v = 2166136261UL;
+    int k;
+
+    for(k = 0; k < 3; ++k)          /* FNV-1a of the cell index */
+    {
+        v ^= (unsigned long) (x[k]/h);
+        v = (v*16777619UL) & 0xffffffffUL;
+    }
+
+    return 0.02*(v % 1000)/1000.0;
+}
+
+
+static const struct BenchField bench_fields[] = {
+    {"droplets", dropletsField},
+    {"sheet", sheetField},
+    {"ligaments", ligamentsField},
+    {"noise", noiseField}
+};
+
+#define BENCH_N_FIELDS (sizeof(bench_fields)/sizeof(bench_fields[0]))
+
+/* ------------------------------------------------------------------------- */
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: cpad_bench [-m hex|tet|poly] [-c cells,...] [-f fields] "
+                    "[-e flood,uf,inc] [-r repeats] [-o file.csv]\n");
+    exit(EXIT_FAILURE);
+}
+
+
+static int splitList(char *s, char **items)   /* in place, returns count */
+{
+    int n = 0;
+    char *tok;
+
+    for(tok = strtok(s, ","); tok != NULL && n < BENCH_MAX_ITEMS; tok = strtok(NULL, ","))
+    {
+        items[n++] = tok;
+    }
+
+    return n;
+}
+
+
+static double peakRssMb(void)
+{
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+
+    return ru.ru_maxrss/1024.0;         /* kilobytes on Linux */
+}
+
+
+static void removeResults(void)
+{
+    remove("0_cpa.bin");
+    remove("0_cpa.txt");
+    remove("cpa_global.bin");
+    remove("cpa_global.txt");
+    remove("cpa_profile.csv");
+}
+
+
+int main(int argc, char **argv)
+{
+    char default_cells[] = "1e4,1e5,1e6";
+    char default_fields[] = "droplets,sheet,ligaments,noise";
+    char default_engines[] = "flood,uf";
+    char *cells_arg = default_cells, *fields_arg = default_fields;
+    char *engines_arg = default_engines;
+    char *cells[BENCH_MAX_ITEMS], *fields[BENCH_MAX_ITEMS], *engines[BENCH_MAX_ITEMS];
+    int no_cells, no_fields, no_engines;
+    char mesh = 'h';
+    const char *mesh_name = NULL;
+    int repeats = 3;
+    const char *csv_name = NULL;
+    FILE *csv = NULL;
+    int i, ic, ifd, ie, r;
+
+    for(i = 1; i < argc; ++i)
+    {
+        if(i + 1 >= argc)
+        {
+            usage();
+        }
+
+        if(strcmp(argv[i], "-m") == 0)
+        {
+            mesh = argv[++i][0];
+        }
+        else if(strcmp(argv[i], "-c") == 0)
+        {
+            cells_arg = argv[++i];
+        }
+        else if(strcmp(argv[i], "-f") == 0)
+        {
+            fields_arg = argv[++i];
+        }
+        else if(strcmp(argv[i], "-e") == 0)
+        {
+            engines_arg = argv[++i];
+        }
+        else if(strcmp(argv[i], "-r") == 0)
+        {
+            repeats = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-o") == 0)
+        {
+            csv_name = argv[++i];
+        }
+        else
+        {
+            usage();
+        }
+    }
+
+    no_cells = splitList(cells_arg, cells);
+    no_fields = splitList(fields_arg, fields);
+    no_engines = splitList(engines_arg, engines);
+
+    if(repeats < 1 || (mesh != 'h' && mesh != 't' && mesh != 'p'))
+    {
+        usage();
+    }
+
+    if(csv_name != NULL)
+    {
+        csv = fopen(csv_name, "w");
+
+        if(csv == NULL)
+        {
+            fprintf(stderr, "cpad_bench: cannot open %s\n", csv_name);
+            return EXIT_FAILURE;
+        }
+
+        fprintf(csv, "mesh,cells,field,engine,cpas,adjacency_s,labelling_s,reduction_s,"
+                     "stitching_s,output_s,total_s,cells_per_s,cpas_per_s,arena_mb,"
+                     "peak_rss_mb\n");
+    }
+
+    sa_quiet = 1;
+
+    printf("%-5s %10s %-10s %-6s %9s %9s %9s %9s %9s %9s %9s %10s %8s %8s\n",
+           "mesh", "cells", "field", "engine", "cpas", "adjac.[s]", "label[s]",
+           "reduce[s]", "stitch[s]", "output[s]", "total[s]", "Mcells/s", "arena MB",
+           "rss MB");
+
+    for(ic = 0; ic < no_cells; ++ic)
+    {
+        int n = (int) floor(cbrt(atof(cells[ic])) + 0.5);
+        Domain *d = NULL;
+        struct BenchCtx ctx;
+
+        if(n < 1)
+        {
+            usage();
+        }
+
+        switch(mesh)
+        {
+            case 'h': d = saBuildHexMesh(n, n, n, 1.0/n); mesh_name = "hex"; break;
+            case 't': d = saBuildTetMesh(n, n, n, 1.0/n); mesh_name = "tet"; break;
+            case 'p': d = saBuildPolyMesh(n, n, n, 1.0/n); mesh_name = "poly"; break;
+        }
+
+        ctx.h = 1.0/n;
+        CPAD_RESET_oD();
+
+        for(ifd = 0; ifd < no_fields; ++ifd)
+        {
+            const struct BenchField *field = NULL;
+            size_t k;
+
+            for(k = 0; k < BENCH_N_FIELDS; ++k)
+            {
+                if(strcmp(fields[ifd], bench_fields[k].name) == 0)
+                {
+                    field = &bench_fields[k];
+                }
+            }
+
+            if(field == NULL)
+            {
+                fprintf(stderr, "cpad_bench: unknown field %s\n", fields[ifd]);
+                usage();
+            }
+
+            saSetVof(d, 0, field->alpha, &ctx);
+
+            for(ie = 0; ie < no_engines; ++ie)
+            {
+                struct CpaTimings sum;
+                double adjacency;
+
+                if(strcmp(engines[ie], "uf") == 0)
+                {
+                    CPAD_UNION_FIND_oD();
+                }
+                else if(strcmp(engines[ie], "flood") == 0)
+                {
+                    CPAD_FLOOD_FILL_oD();
+                }
+                else if(strcmp(engines[ie], "inc") == 0)
+                {
+                    CPAD_INCREMENTAL_oD();
+                }
+                else
+                {
+                    usage();
+                }
+
+                /* warm up, builds the neighbor graph on first use of the mesh */
+                CPAD_aE();
+                adjacency = cpa_timings.adjacency;
+                memset(&sum, 0, sizeof(sum));
+
+                for(r = 0; r < repeats; ++r)
+                {
+                    CPAD_aE();
+                    sum.labelling += cpa_timings.labelling/repeats;
+                    sum.reduction += cpa_timings.reduction/repeats;
+                    sum.stitching += cpa_timings.stitching/repeats;
+                    sum.output += cpa_timings.output/repeats;
+                    sum.total += cpa_timings.total/repeats;
+                }
+
+                CPAD_aX();
+                removeResults();
+
+                printf("%-5s %10i %-10s %-6s %9i %9.4f %9.4f %9.4f %9.4f %9.4f %9.4f "
+                       "%10.2f %8.1f %8.1f\n",
+                       mesh_name, cpa_timings.no_cells, field->name, engines[ie],
+                       cpa_timings.no_cpas, adjacency, sum.labelling, sum.reduction,
+                       sum.stitching, sum.output, sum.total,
+                       cpa_timings.no_cells/sum.total/1e6,
+                       cpa_timings.arena_bytes/1048576.0, peakRssMb());
+                fflush(stdout);
+
+                if(csv != NULL)
+                {
+                    fprintf(csv, "%s,%i,%s,%s,%i,%g,%g,%g,%g,%g,%g,%g,%g,%g,%g\n",
+                            mesh_name, cpa_timings.no_cells, field->name, engines[ie],
+                            cpa_timings.no_cpas, adjacency, sum.labelling, sum.reduction,
+                            sum.stitching, sum.output, sum.total,
+                            cpa_timings.no_cells/sum.total,
+                            cpa_timings.no_cpas/sum.total,
+                            cpa_timings.arena_bytes/1048576.0, peakRssMb());
+                }
+            }
+        }
+
+        saFreeDomain(d);
+    }
+
+    if(csv != NULL)
+    {
+        fclose(csv);
+    }
+
+    return 0;
+}
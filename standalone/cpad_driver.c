@@ -0,0 +1,197 @@
+/*
+Standalone driver for the cpad UDF library: builds a mesh with the generators
+of sa_mesh.c, sets a synthetic VOF field of the detected phase and runs the
+detection like Fluent would (CPAD_aE after every time step, CPAD_aX at exit).
+
+Usage:
+    cpad_driver [-m hex|tet|poly] [-n cells] [-e flood|uf|inc] [-s steps] [-b] [-q]
+                [-v name=value ...]
+
+    -m  mesh type (default hex)
+    -n  cells per direction (default 40)
+    -e  labelling engine (default _ENGINE of vof_droplet_detection.c)
+    -s  number of time steps, the droplets move along x (default 1)
+    -b  batch mode: every step is evaluated like a data file of a batch run 
+        (CPAD_BATCH_oD, index in cpa_batch.csv) instead of CPAD_aE
+    -q  no Message() output
+    -v  define an RP variable, e.g. -v cpad/min-vol-frac=0.05 or
+        -v "cpad/phases=0 1" (lists separated by blanks)
+
+The results are written to the working directory (0_cpa.bin, cpa_global.bin
+or the text files, depending on _OUTPUT).
+ */
+
+#include "udf.h"
+#include "sa_mesh.h"
+
+void CPAD_aE(void);
+void CPAD_BATCH_oD(void);
+void CPAD_aX(void);
+void CPAD_FLOOD_FILL_oD(void);
+void CPAD_UNION_FIND_oD(void);
+void CPAD_INCREMENTAL_oD(void);
+
+struct SpheresField
+{
+    real shift;                         /* displacement along x */
+};
+
+/* 4x4x4 droplets of different size with a thin low alpha shell and a liquid
+   film at the bottom of the unit cube */
+static real spheresField(const real x[ND_ND], void *ctx)
+{
+    struct SpheresField *f = (struct SpheresField*) ctx;
+    real dx, dy, dz, r;
+    int i, j, k;
+
+    for(i = 0; i < 4; ++i)
+    for(j = 0; j < 4; ++j)
+    for(k = 0; k < 4; ++k)
+    {
+        dx = x[0] - (0.125 + 0.25*i + f->shift);
+        dy = x[1] - (0.125 + 0.25*j);
+        dz = x[2] - (0.125 + 0.25*k);
+        r = sqrt(dx*dx + dy*dy + dz*dz);
+
+        if(r < 0.05 + 0.02*((i + j + k) % 3))
+        {
+            return 1.0;
+        }
+
+        if(r < 0.08)
+        {
+            return 0.005;
+        }
+    }
+
+    if(x[2] < 0.03)
+    {
+        return 0.7;
+    }
+
+    return 0.0;
+}
+
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: cpad_driver [-m hex|tet|poly] [-n cells] [-e flood|uf|inc] "
+                    "[-s steps] [-b] [-q] [-v name=value ...]\n");
+    exit(EXIT_FAILURE);
+}
+
+
+int main(int argc, char **argv)
+{
+    char mesh = 'h';
+    int n = 40;
+    int steps = 1;
+    int batch = 0;
+    int i;
+    char rp_value[32];
+    Domain *d = NULL;
+    struct SpheresField field;
+
+    for(i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+        {
+            mesh = argv[++i][0];
+        }
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            n = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            steps = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+        {
+            ++i;
+
+            if(strcmp(argv[i], "uf") == 0)
+            {
+                CPAD_UNION_FIND_oD();
+            }
+            else if(strcmp(argv[i], "flood") == 0)
+            {
+                CPAD_FLOOD_FILL_oD();
+            }
+            else if(strcmp(argv[i], "inc") == 0)
+            {
+                CPAD_INCREMENTAL_oD();
+            }
+            else
+            {
+                usage();
+            }
+        }
+        else if(strcmp(argv[i], "-b") == 0)
+        {
+            batch = 1;
+        }
+        else if(strcmp(argv[i], "-q") == 0)
+        {
+            sa_quiet = 1;
+        }
+        else if(strcmp(argv[i], "-v") == 0 && i + 1 < argc)
+        {
+            char *value = strchr(argv[++i], '=');
+
+            if(value == NULL)
+            {
+                usage();
+            }
+
+            *value++ = '\0';
+
+            if(!saSetRpVar(argv[i], value))
+            {
+                usage();
+            }
+        }
+        else
+        {
+            usage();
+        }
+    }
+
+    if(n < 1 || steps < 1)
+    {
+        usage();
+    }
+
+    switch(mesh)
+    {
+        case 'h': d = saBuildHexMesh(n, n, n, 1.0/n); break;
+        case 't': d = saBuildTetMesh(n, n, n, 1.0/n); break;
+        case 'p': d = saBuildPolyMesh(n, n, n, 1.0/n); break;
+        default: usage();
+    }
+
+    for(i = 0; i < steps; ++i)
+    {
+        field.shift = 0.01*i;
+        sa_current_time = 0.001*i;
+        saSetVof(d, 0, spheresField, &field);
+
+        if(batch)
+        {
+            sprintf(rp_value, "%i", i);
+            saSetRpVar("cpad/batch-index", rp_value);
+            sprintf(rp_value, "step-%04i.dat", i);
+            saSetRpVar("cpad/batch-file", rp_value);
+            CPAD_BATCH_oD();
+        }
+        else
+        {
+            CPAD_aE();
+        }
+    }
+
+    CPAD_aX();
+    saFreeDomain(d);
+
+    return 0;
+}
@@ -0,0 +1,606 @@
+/*
+Parallel test of the cpad UDF library (built with SA_PARALLEL=1, see
+sa_par.c): the detection runs on 1 compute node and on several compute nodes
+holding partitions of the same mesh. The cpa label of every cell (_LABEL_UDM,
+the stitched global id) and the track id of its cpa (cpa_tracks.txt) have to
+be the same in both runs, up to the numbering of the global cpas and tracks,
+and so have the tracking summaries of node 0 (cpas continued by overlap, by
+distance and new ones). This covers the fragment exchange and stitching, the
+track exchange and the labels of every compute node.
+
+With -f the error paths are tested instead: in the last step one allocation
+of the library fails on the given compute node, for the first, second, ...
+allocation of that step until the step needs no more. All compute nodes have
+to finish the step and the next one, none may hang or crash.
+
+Usage:
+    cpad_partest [-m hex|tet|poly] [-n cells] [-p compute nodes] [-s steps]
+                 [-f compute node] [-v name=value ...]
+
+    -m  mesh type (default hex)
+    -n  cells per direction (default 24)
+    -p  compute nodes of the parallel run (default 3)
+    -s  number of time steps, the cpas move along x (default 3)
+    -f  compute node with the failing allocations
+    -v  define an RP variable, e.g. -v cpad/connectivity=2
+
+Returns 0 if both runs agree. The result files of the runs and the messages
+of every compute node (node<myid>.log) are written to the working directory.
+ */
+
+#include "udf.h"
+#include "sa_mesh.h"
+#include "sa_par.h"
+
+void CPAD_aE(void);
+void CPAD_aX(void);
+
+#define PARTEST_LABEL_UDM 1
+#define PARTEST_TIMEOUT 60              /* seconds, longer runs hang */
+#define PARTEST_MAX_LOG 65536
+
+struct PartestField
+{
+    real shift;                         /* displacement along x */
+    real h;                             /* cell size */
+};
+
+struct PartestRun
+{
+    Domain *d;                          /* serial mesh */
+    int n;
+    int steps;
+    int fail_rank;                      /* -1: no failing allocations */
+    long fail_alloc;                    /* failing allocation of the last step */
+    FILE *result;                       /* labels and tracks per step (node 0) */
+    FILE *failed;                       /* written if the allocation failed */
+    char tracked[PARTEST_MAX_LOG];      /* tracking summaries of node 0 */
+};
+
+/* spheres cut by the partition boundaries, a column through all partitions,
+   a film at the bottom and a chain of cells only connected by their
+   vertices (one cpa with cpad/connectivity 2) */
+static real partestField(const real x[ND_ND], void *ctx)
+{
+    struct PartestField *f = (struct PartestField*) ctx;
+    static const real zc[5] = {0.25, 1.0/3.0, 0.5, 2.0/3.0, 0.75};
+    real dx, dy, dz;
+    int i, ci[3];
+
+    for(i = 0; i < 5; ++i)
+    {
+        dx = x[0] - (0.12 + 0.17*i + f->shift);
+        dy = x[1] - 0.25;
+        dz = x[2] - zc[i];
+
+        if(dx*dx + dy*dy + dz*dz < 0.07*0.07)
+        {
+            return 1.0;
+        }
+    }
+
+    dx = x[0] - (0.8 + f->shift);
+    dy = x[1] - 0.8;
+
+    if(dx*dx + dy*dy < 0.06*0.06)
+    {
+        return 0.9;
+    }
+
+    if(x[2] < 0.03)
+    {
+        return 0.7;
+    }
+
+    for(i = 0; i < 3; ++i)
+    {
+        ci[i] = (int) floor(x[i]/f->h);
+    }
+
+    if(ci[1] == ci[2] && ci[0] + ci[1] == (int) floor(1.0/f->h + 0.5) - 1
+        && x[0] > 0.1 && x[0] < 0.9)
+    {
+        return 1.0;
+    }
+
+    return 0.0;
+}
+
+
+static int partestTracks(int *tracks, int max_tracks)
+{
+/*
+    Track id of every global cpa of the last block of cpa_tracks.txt,
+    returns the number of global cpas or -1
+*/
+    FILE *fd = fopen("cpa_tracks.txt", "r");
+    char line[128];
+    int g, t;
+    int n = -1;
+
+    if(fd == NULL)
+    {
+        return -1;
+    }
+
+    while(fgets(line, sizeof(line), fd) != NULL)
+    {
+        if(line[0] == '{')
+        {
+            n = 0;
+        }
+        else if(n >= 0 && sscanf(line, "%i,%i", &g, &t) == 2)
+        {
+            if(g != n || n == max_tracks)
+            {
+                n = -1;
+                break;
+            }
+            tracks[n++] = t;
+        }
+    }
+
+    fclose(fd);
+
+    return n;
+}
+
+
+static int partestRank(void *ctx)
+{
+/*
+    One compute node: detection on its partition, node 0 collects the label
+    and the track id of every cell after each step
+*/
+    struct PartestRun *run = (struct PartestRun*) ctx;
+    int no_cells = run->d->c->n_int;
+    Domain *ld = saPartitionDomain(run->d, compute_node_count, myid);
+    Thread *ct = ld->c;
+    struct PartestField field;
+    int *cid, *label, *labels, *tracks, *cell_tracks;
+    int n, i, r, step, no_tracks, failed;
+    char log[32];
+
+    sprintf(log, "node%i.log", myid);
+
+    if(freopen(log, "w", stdout) == NULL)
+    {
+        fprintf(stderr, "cpad_partest: cannot write %s\n", log);
+        return 1;
+    }
+
+    saSetActiveDomain(ld);
+    field.h = 1.0/run->n;
+
+    cid = (int*) malloc((no_cells + 1)*sizeof(int));
+    label = (int*) malloc((no_cells + 1)*sizeof(int));
+    labels = (int*) malloc((no_cells + 1)*sizeof(int));
+    tracks = (int*) malloc((no_cells + 1)*sizeof(int));
+    cell_tracks = (int*) malloc((no_cells + 1)*sizeof(int));
+
+    if(cid == NULL || label == NULL || labels == NULL || tracks == NULL
+        || cell_tracks == NULL)
+    {
+        fprintf(stderr, "cpad_partest: out of memory\n");
+        return 1;
+    }
+
+    for(step = 0; step < run->steps; ++step)
+    {
+        field.shift = 0.01*step;
+        sa_current_time = 0.001*step;
+        saSetVof(ld, 0, partestField, &field);
+
+        if(run->fail_rank == myid && step == run->steps - 1)
+        {
+            saParFailAlloc(run->fail_alloc);
+        }
+
+        CPAD_aE();
+        failed = saParFailDone();
+        saParFailAlloc(0);
+
+        if(run->fail_rank >= 0 && step == run->steps - 1)
+        {
+            if(failed)
+            {
+                fputc('1', run->failed);
+                fflush(run->failed);
+            }
+
+            /* the next step has to work again */
+            CPAD_aE();
+            break;
+        }
+
+        n = ct->n_int;
+
+        for(i = 0; i < n; ++i)
+        {
+            cid[i] = C_ID(i, ct);
+            label[i] = (int) C_UDMI(i, ct, PARTEST_LABEL_UDM);
+        }
+
+        if(myid != node_zero)
+        {
+            saParSend(node_zero, myid, &n, sizeof(int));
+            saParSend(node_zero, myid, cid, n*sizeof(int));
+            saParSend(node_zero, myid, label, n*sizeof(int));
+            continue;
+        }
+
+        for(r = 0; r < compute_node_count; ++r)
+        {
+            if(r != node_zero)
+            {
+                saParRecv(r, r, &n, sizeof(int));
+                saParRecv(r, r, cid, n*sizeof(int));
+                saParRecv(r, r, label, n*sizeof(int));
+            }
+
+            for(i = 0; i < n; ++i)
+            {
+                labels[cid[i]] = label[i];
+            }
+        }
+
+        no_tracks = partestTracks(tracks, no_cells);
+
+        if(no_tracks < 0)
+        {
+            fprintf(stderr, "cpad_partest: no tracks in cpa_tracks.txt\n");
+            return 1;
+        }
+
+        for(i = 0; i < no_cells; ++i)
+        {
+            cell_tracks[i] = (labels[i] > 0 && labels[i] <= no_tracks) ?
+                                tracks[labels[i] - 1] : -1;
+        }
+
+        fwrite(labels, sizeof(int), no_cells, run->result);
+        fwrite(cell_tracks, sizeof(int), no_cells, run->result);
+        fflush(run->result);
+    }
+
+    CPAD_aX();
+
+    free(cid);
+    free(label);
+    free(labels);
+    free(tracks);
+    free(cell_tracks);
+    saFreeDomain(ld);
+
+    return 0;
+}
+
+
+static void partestTracked(char *tracked)
+{
+/*
+    Tracking summaries ("Tracked ...") in the messages of node 0
+*/
+    FILE *fd = fopen("node0.log", "r");
+    char line[256];
+    size_t len = 0;
+
+    tracked[0] = '\0';
+
+    while(fd != NULL && fgets(line, sizeof(line), fd) != NULL)
+    {
+        if(strncmp(line, "Tracked", 7) == 0 && len + strlen(line) < PARTEST_MAX_LOG)
+        {
+            strcpy(tracked + len, line);
+            len += strlen(line);
+        }
+    }
+
+    if(fd != NULL)
+    {
+        fclose(fd);
+    }
+}
+
+
+static int partestRun(struct PartestRun *run, int no_ranks, int *values)
+{
+/*
+    Detection on no_ranks compute nodes, values gets the labels and tracks
+    of all cells per step (not with failing allocations)
+*/
+    size_t n = (size_t) 2*run->steps*run->d->c->n_int;
+
+    remove("cpa_tracks.txt");
+    run->result = tmpfile();
+
+    if(run->result == NULL)
+    {
+        perror("cpad_partest: tmpfile");
+        return 1;
+    }
+
+    if(saParRun(no_ranks, PARTEST_TIMEOUT, partestRank, run) != 0)
+    {
+        fclose(run->result);
+        return 1;
+    }
+
+    if(values == NULL)
+    {
+        fclose(run->result);
+        return 0;
+    }
+
+    rewind(run->result);
+
+    if(fread(values, sizeof(int), n, run->result) != n)
+    {
+        fprintf(stderr, "cpad_partest: missing results of %i compute nodes\n", no_ranks);
+        fclose(run->result);
+        return 1;
+    }
+
+    fclose(run->result);
+    partestTracked(run->tracked);
+
+    return 0;
+}
+
+
+static int partestSame(const int *a, const int *b, int n, int max_id, const char *what)
+{
+/*
+    1 if the ids a and b (-1 or 0: none, up to max_id) describe the same
+    sets of cells
+*/
+    int *a2b = (int*) malloc((max_id + 1)*sizeof(int));
+    int *b2a = (int*) malloc((max_id + 1)*sizeof(int));
+    int i, same = 1;
+
+    if(a2b == NULL || b2a == NULL)
+    {
+        fprintf(stderr, "cpad_partest: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for(i = 0; i <= max_id; ++i)
+    {
+        a2b[i] = -1;
+        b2a[i] = -1;
+    }
+
+    for(i = 0; i < n && same; ++i)
+    {
+        if((a[i] > 0) != (b[i] > 0) || a[i] > max_id || b[i] > max_id)
+        {
+            same = 0;
+        }
+        else if(a[i] > 0)
+        {
+            if(a2b[a[i]] == -1 && b2a[b[i]] == -1)
+            {
+                a2b[a[i]] = b[i];
+                b2a[b[i]] = a[i];
+            }
+
+            same = (a2b[a[i]] == b[i] && b2a[b[i]] == a[i]);
+        }
+    }
+
+    if(!same)
+    {
+        fprintf(stderr, "cpad_partest: %s of cell %i differ (%i, %i)\n", what, i - 1,
+                a[i-1], b[i-1]);
+    }
+
+    free(a2b);
+    free(b2a);
+
+    return same;
+}
+
+
+static int partestFail(struct PartestRun *run, const char *mesh, int no_ranks)
+{
+/*
+    Fail every allocation of the last step on compute node run->fail_rank
+    once, returns EXIT_SUCCESS if all compute nodes finished each time
+*/
+    int failed = 1;
+
+    for(run->fail_alloc = 1; failed; ++run->fail_alloc)
+    {
+        run->failed = tmpfile();
+
+        if(run->failed == NULL)
+        {
+            perror("cpad_partest: tmpfile");
+            return EXIT_FAILURE;
+        }
+
+        if(partestRun(run, no_ranks, NULL) != 0)
+        {
+            fprintf(stderr, "cpad_partest: allocation %li failed on compute node %i\n",
+                    run->fail_alloc, run->fail_rank);
+            printf("cpad_partest -m %s -n %i -p %i -s %i -f %i: FAILED\n", mesh,
+                    run->n, no_ranks, run->steps, run->fail_rank);
+            return EXIT_FAILURE;
+        }
+
+        rewind(run->failed);
+        failed = (fgetc(run->failed) == '1');
+        fclose(run->failed);
+    }
+
+    printf("cpad_partest -m %s -n %i -p %i -s %i -f %i: %li failing allocations, ok\n",
+            mesh, run->n, no_ranks, run->steps, run->fail_rank, run->fail_alloc - 2);
+
+    return EXIT_SUCCESS;
+}
+
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: cpad_partest [-m hex|tet|poly] [-n cells] [-p compute nodes] "
+                    "[-s steps] [-f compute node] [-v name=value ...]\n");
+    exit(EXIT_FAILURE);
+}
+
+
+int main(int argc, char **argv)
+{
+    const char *mesh = "hex";
+    int no_ranks = 3;
+    int no_cells, step, i, ok;
+    int no_cpas = 0;
+    int *serial, *parallel, *a, *b;
+    char *tracked;
+    struct PartestRun run;
+    char udm[16];
+
+    run.n = 24;
+    run.steps = 3;
+    run.fail_rank = -1;
+
+    for(i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+        {
+            mesh = argv[++i];
+        }
+        else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            run.n = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+        {
+            no_ranks = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            run.steps = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+        {
+            run.fail_rank = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-v") == 0 && i + 1 < argc)
+        {
+            char *value = strchr(argv[++i], '=');
+
+            if(value == NULL)
+            {
+                usage();
+            }
+
+            *value++ = '\0';
+
+            if(!saSetRpVar(argv[i], value))
+            {
+                usage();
+            }
+        }
+        else
+        {
+            usage();
+        }
+    }
+
+    if(run.n < 2 || run.steps < 1 || no_ranks < 1 || no_ranks > SA_MAX_RANKS
+        || run.fail_rank >= no_ranks)
+    {
+        usage();
+    }
+
+    switch(mesh[0])
+    {
+        case 'h': run.d = saBuildHexMesh(run.n, run.n, run.n, 1.0/run.n); break;
+        case 't': run.d = saBuildTetMesh(run.n, run.n, run.n, 1.0/run.n); break;
+        case 'p': run.d = saBuildPolyMesh(run.n, run.n, run.n, 1.0/run.n); break;
+        default: usage();
+    }
+
+    sprintf(udm, "%i", PARTEST_LABEL_UDM);
+    saSetRpVar("cpad/label-udm", udm);
+
+    if(run.fail_rank >= 0)
+    {
+        return partestFail(&run, mesh, no_ranks);
+    }
+
+    no_cells = run.d->c->n_int;
+    serial = (int*) malloc((size_t) 2*run.steps*no_cells*sizeof(int));
+    parallel = (int*) malloc((size_t) 2*run.steps*no_cells*sizeof(int));
+
+    if(serial == NULL || parallel == NULL)
+    {
+        fprintf(stderr, "cpad_partest: out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    tracked = (char*) malloc(PARTEST_MAX_LOG);
+
+    if(tracked == NULL || partestRun(&run, 1, serial) != 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    strcpy(tracked, run.tracked);
+
+    if(partestRun(&run, no_ranks, parallel) != 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    ok = 1;
+
+    for(step = 0; step < run.steps && ok; ++step)
+    {
+        a = serial + (size_t) 2*step*no_cells;
+        b = parallel + (size_t) 2*step*no_cells;
+        ok = partestSame(a, b, no_cells, no_cells, "labels");
+        no_cpas = 0;
+
+        for(i = 0; i < no_cells; ++i)
+        {
+            no_cpas = (a[i] > no_cpas) ? a[i] : no_cpas;
+        }
+    }
+
+    /* tracks of all steps in one block (one numbering), track id + 1 */
+    for(step = 0; step < run.steps && ok; ++step)
+    {
+        a = serial + (size_t) (2*step + 1)*no_cells;
+        b = parallel + (size_t) (2*step + 1)*no_cells;
+
+        for(i = 0; i < no_cells; ++i)
+        {
+            serial[(size_t) step*no_cells + i] = a[i] + 1;
+            parallel[(size_t) step*no_cells + i] = b[i] + 1;
+        }
+    }
+
+    if(ok)
+    {
+        ok = partestSame(serial, parallel, run.steps*no_cells, run.steps*no_cells + 1,
+                            "tracks");
+    }
+
+    if(ok && (tracked[0] == '\0' || strcmp(tracked, run.tracked) != 0))
+    {
+        fprintf(stderr, "cpad_partest: tracking summaries differ:\n%s---\n%s", tracked,
+                run.tracked);
+        ok = 0;
+    }
+
+    printf("cpad_partest -m %s -n %i -p %i -s %i: %i global cpas in the last step, %s\n",
+            mesh, run.n, no_ranks, run.steps, no_cpas, ok ? "ok" : "FAILED");
+
+    free(serial);
+    free(parallel);
+    free(tracked);
+    saFreeDomain(run.d);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,3 @@
+/*
+Stand-in for the ANSYS Fluent mem.h header (see udf.h in this folder).
+ */
@@ -0,0 +1,1513 @@
+/*
+In-memory unstructured mesh and session state behind the udf.h stand-in.
+
+Meshes are assembled from cells given as lists of polygonal faces (node
+coordinates). Coincident nodes and faces are merged, so every generator only
+has to describe single cells:
+    - saBuildHexMesh  : structured hexahedral grid (assembled directly)
+    - saBuildTetMesh  : hex grid split into 6 tetrahedra per hex (Kuhn)
+    - saBuildPolyMesh : extruded honeycomb (hexagonal prisms, 8 faces/cell)
+
+Boundary faces are sorted into six boundary zones by bounding box side
+(ids SA_BOUNDARY_ID_XMIN ... SA_BOUNDARY_ID_ZMAX).
+ */
+
+#include <limits.h>
+#include <stdarg.h>
+#include "udf.h"
+#include "sa_mesh.h"
+
+int myid = 0;
+int node_zero = 0;
+int compute_node_count = 1;
+real sa_current_time = 0.0;
+int sa_n_udm = SA_MAX_UDM;
+
+int sa_quiet = 0;
+
+static Domain *sa_domain = NULL;
+
+#define SA_MAX_RP_VARS 32
+
+static struct
+{
+    char name[64];
+    char value[256];
+} sa_rp_vars[SA_MAX_RP_VARS];
+
+static int sa_no_rp_vars = 0;
+
+/* ------------------------------------------------------------------------- */
+
+void Message(const char *fmt, ...)
+{
+    va_list ap;
+
+    if(sa_quiet)
+    {
+        return;
+    }
+
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+}
+
+
+Domain *Get_Domain(int id)
+{
+    (void) id;
+    return sa_domain;
+}
+
+
+Thread *Lookup_Thread(Domain *d, int id)
+{
+    Thread *t;
+
+    if(d == NULL)
+    {
+        return NULL;
+    }
+
+    thread_loop_c(t, d)
+    {
+        if(t->id == id)
+        {
+            return t;
+        }
+    }
+
+    thread_loop_f(t, d)
+    {
+        if(t->id == id)
+        {
+            return t;
+        }
+    }
+
+    return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+/* RP variables */
+
+int saSetRpVar(const char *name, const char *value)	/* define or change */
+{
+    int i;
+
+    if(strlen(name) >= sizeof(sa_rp_vars[0].name)
+       || strlen(value) >= sizeof(sa_rp_vars[0].value))
+    {
+        return 0;
+    }
+
+    for(i = 0; i < sa_no_rp_vars; ++i)
+    {
+        if(strcmp(sa_rp_vars[i].name, name) == 0)
+        {
+            break;
+        }
+    }
+
+    if(i == SA_MAX_RP_VARS)
+    {
+        return 0;
+    }
+
+    if(i == sa_no_rp_vars)
+    {
+        sa_no_rp_vars++;
+    }
+
+    strcpy(sa_rp_vars[i].name, name);
+    strcpy(sa_rp_vars[i].value, value);
+
+    return 1;
+}
+
+
+static const char *saRpValue(const char *name)
+{
+    int i;
+
+    for(i = 0; i < sa_no_rp_vars; ++i)
+    {
+        if(strcmp(sa_rp_vars[i].name, name) == 0)
+        {
+            return sa_rp_vars[i].value;
+        }
+    }
+
+    fprintf(stderr, "RP variable %s is not defined\n", name);
+    exit(EXIT_FAILURE);
+}
+
+
+int RP_Variable_Exists_P(char *name)
+{
+    int i;
+
+    for(i = 0; i < sa_no_rp_vars; ++i)
+    {
+        if(strcmp(sa_rp_vars[i].name, name) == 0)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+real RP_Get_Real(char *name)
+{
+    return atof(saRpValue(name));
+}
+
+
+int RP_Get_Integer(char *name)
+{
+    return atoi(saRpValue(name));
+}
+
+
+char *RP_Get_String(char *name)
+{
+    return (char*) saRpValue(name);
+}
+
+
+int RP_Get_List_Length(char *name)
+{
+    const char *v = saRpValue(name);
+    int n = 0;
+
+    while(*v != '\0')
+    {
+        v += strspn(v, " ");
+
+        if(*v != '\0')
+        {
+            n++;
+            v += strcspn(v, " ");
+        }
+    }
+
+    return n;
+}
+
+
+static const char *saRpListItem(char *name, int i)
+{
+    const char *v = saRpValue(name);
+
+    v += strspn(v, " ");
+
+    while(i-- > 0 && *v != '\0')
+    {
+        v += strcspn(v, " ");
+        v += strspn(v, " ");
+    }
+
+    return v;
+}
+
+
+int RP_Get_List_Ref_Int(char *name, int i)
+{
+    return atoi(saRpListItem(name, i));
+}
+
+
+real RP_Get_List_Ref_Float(char *name, int i)
+{
+    return atof(saRpListItem(name, i));
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void *saMalloc(size_t size)
+{
+    void *p = malloc(size > 0 ? size : 1);
+
+    if(p == NULL)
+    {
+        fprintf(stderr, "sa_mesh: out of memory (%lu bytes)\n", (unsigned long) size);
+        exit(EXIT_FAILURE);
+    }
+
+    return p;
+}
+
+
+static void *saRealloc(void *p, size_t size)
+{
+    p = realloc(p, size > 0 ? size : 1);
+
+    if(p == NULL)
+    {
+        fprintf(stderr, "sa_mesh: out of memory (%lu bytes)\n", (unsigned long) size);
+        exit(EXIT_FAILURE);
+    }
+
+    return p;
+}
+
+/* ------------------------------------------------------------------------- */
+/* mesh builder */
+
+#define SA_MAX_FACE_NODES 8
+
+struct SaBuilder
+{
+    real quantum;
+
+    /* nodes */
+    real *x;
+    int n_nodes, cap_nodes;
+    long long *node_keys;               /* 3 quantized coords per slot */
+    int *node_slots;                    /* hash slot -> node index */
+    int node_hash_size;
+
+    /* cells and their faces (node lists) */
+    int *cell_face_offset;
+    int n_cells, cap_cells;
+    int *face_node_offset;              /* per cell face */
+    int *face_nodes;
+    int n_faces, cap_faces;
+    int n_face_nodes, cap_face_nodes;
+};
+
+
+static unsigned long saHashInts(const long long *v, int n)
+{
+    unsigned long long h = 1469598103934665603ULL;
+    int i;
+
+    for(i = 0; i < n; ++i)
+    {
+        h ^= (unsigned long long) v[i];
+        h *= 1099511628211ULL;
+        h ^= h >> 29;
+    }
+
+    return (unsigned long) h;
+}
+
+
+static void saBuilderInit(struct SaBuilder *b, real h, int expected_nodes)
+{
+    int i;
+
+    memset(b, 0, sizeof(*b));
+    b->quantum = h*1e-6;
+    b->node_hash_size = 1024;
+
+    while(b->node_hash_size < 2*expected_nodes)
+    {
+        b->node_hash_size *= 2;
+    }
+
+    b->node_slots = (int*) saMalloc(b->node_hash_size*sizeof(int));
+
+    for(i = 0; i < b->node_hash_size; ++i)
+    {
+        b->node_slots[i] = -1;
+    }
+
+    b->cell_face_offset = (int*) saMalloc(sizeof(int));
+    b->cell_face_offset[0] = 0;
+    b->face_node_offset = (int*) saMalloc(sizeof(int));
+    b->face_node_offset[0] = 0;
+}
+
+
+static void saBuilderRehashNodes(struct SaBuilder *b)
+{
+    int i, slot;
+    unsigned long mask;
+
+    free(b->node_slots);
+    b->node_hash_size *= 2;
+    b->node_slots = (int*) saMalloc(b->node_hash_size*sizeof(int));
+    mask = (unsigned long) b->node_hash_size - 1;
+
+    for(i = 0; i < b->node_hash_size; ++i)
+    {
+        b->node_slots[i] = -1;
+    }
+
+    for(i = 0; i < b->n_nodes; ++i)
+    {
+        slot = (int) (saHashInts(&b->node_keys[3*i], 3) & mask);
+
+        while(b->node_slots[slot] != -1)
+        {
+            slot = (int) ((slot + 1) & mask);
+        }
+
+        b->node_slots[slot] = i;
+    }
+}
+
+
+static int saBuilderNode(struct SaBuilder *b, const real x[3])
+{
+    long long key[3];
+    unsigned long mask;
+    int k, slot, idx;
+
+    for(k = 0; k < 3; ++k)
+    {
+        key[k] = llround(x[k]/b->quantum);
+    }
+
+    if(2*(b->n_nodes + 1) > b->node_hash_size)
+    {
+        saBuilderRehashNodes(b);
+    }
+
+    mask = (unsigned long) b->node_hash_size - 1;
+    slot = (int) (saHashInts(key, 3) & mask);
+
+    while((idx = b->node_slots[slot]) != -1)
+    {
+        if(b->node_keys[3*idx] == key[0] && b->node_keys[3*idx+1] == key[1]
+            && b->node_keys[3*idx+2] == key[2])
+        {
+            return idx;
+        }
+        slot = (int) ((slot + 1) & mask);
+    }
+
+    if(b->n_nodes == b->cap_nodes)
+    {
+        b->cap_nodes = b->cap_nodes ? 2*b->cap_nodes : 1024;
+        b->x = (real*) saRealloc(b->x, 3*b->cap_nodes*sizeof(real));
+        b->node_keys = (long long*) saRealloc(b->node_keys, 3*b->cap_nodes*sizeof(long long));
+    }
+
+    idx = b->n_nodes++;
+
+    for(k = 0; k < 3; ++k)
+    {
+        b->x[3*idx+k] = x[k];
+        b->node_keys[3*idx+k] = key[k];
+    }
+
+    b->node_slots[slot] = idx;
+
+    return idx;
+}
+
+
+static void saBuilderAddFace(struct SaBuilder *b, real (*x)[3], int n)
+{
+    int i;
+
+    if(b->n_faces + 1 >= b->cap_faces)
+    {
+        b->cap_faces = b->cap_faces ? 2*b->cap_faces : 4096;
+        b->face_node_offset = (int*) saRealloc(b->face_node_offset,
+                                            (b->cap_faces + 1)*sizeof(int));
+    }
+
+    if(b->n_face_nodes + n > b->cap_face_nodes)
+    {
+        b->cap_face_nodes = b->cap_face_nodes ? 2*b->cap_face_nodes : 16384;
+        b->face_nodes = (int*) saRealloc(b->face_nodes, b->cap_face_nodes*sizeof(int));
+    }
+
+    for(i = 0; i < n; ++i)
+    {
+        b->face_nodes[b->n_face_nodes++] = saBuilderNode(b, x[i]);
+    }
+
+    b->n_faces++;
+    b->face_node_offset[b->n_faces] = b->n_face_nodes;
+}
+
+
+static void saBuilderEndCell(struct SaBuilder *b)
+{
+    if(b->n_cells + 1 >= b->cap_cells)
+    {
+        b->cap_cells = b->cap_cells ? 2*b->cap_cells : 1024;
+        b->cell_face_offset = (int*) saRealloc(b->cell_face_offset,
+                                            (b->cap_cells + 1)*sizeof(int));
+    }
+
+    b->n_cells++;
+    b->cell_face_offset[b->n_cells] = b->n_faces;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int saCompareInt(const void *a, const void *b)
+{
+    int ia = *(const int*) a;
+    int ib = *(const int*) b;
+
+    return (ia > ib) - (ia < ib);
+}
+
+
+static Thread *saNewThread(Domain *d, int id, int is_cell_thread)
+{
+    Thread *t = (Thread*) saMalloc(sizeof(Thread));
+    Thread **tail;
+
+    memset(t, 0, sizeof(Thread));
+    t->id = id;
+    t->domain = d;
+
+    tail = is_cell_thread ? &d->c : &d->f;
+
+    while(*tail != NULL)
+    {
+        tail = &(*tail)->next;
+    }
+
+    *tail = t;
+
+    return t;
+}
+
+
+static void saInitCellData(Thread *ct)
+{
+/*
+    Partition, cell ids, UDMs and the phase threads (VOF and density) of the
+    cells of ct (n_int and n_ext set)
+*/
+    int n_cells = ct->n_int + ct->n_ext;
+    int c, p;
+
+    ct->part = (int*) saMalloc(n_cells*sizeof(int));
+    ct->cid = (int*) saMalloc(n_cells*sizeof(int));
+    ct->udm = (real*) saMalloc((size_t) n_cells*SA_MAX_UDM*sizeof(real));
+    ct->sub_threads = (Thread**) saMalloc((SA_N_PHASES + 1)*sizeof(Thread*));
+
+    for(c = 0; c < n_cells; ++c)
+    {
+        ct->part[c] = myid;
+        ct->cid[c] = c;
+    }
+
+    memset(ct->udm, 0, (size_t) n_cells*SA_MAX_UDM*sizeof(real));
+
+    for(p = 0; p < SA_N_PHASES; ++p)
+    {
+        Thread *pt = (Thread*) saMalloc(sizeof(Thread));
+
+        memcpy(pt, ct, sizeof(Thread));
+        pt->next = NULL;
+        pt->sub_threads = NULL;
+        pt->storage[SV_VOF] = (real*) saMalloc(n_cells*sizeof(real));
+        pt->storage[SV_DENSITY] = (real*) saMalloc(n_cells*sizeof(real));
+
+        for(c = 0; c < n_cells; ++c)
+        {
+            pt->storage[SV_VOF][c] = (p == 0) ? 0.0 : 1.0;
+            pt->storage[SV_DENSITY][c] = (p == 0) ? SA_LIQUID_DENSITY : SA_GAS_DENSITY;
+        }
+
+        ct->sub_threads[p] = pt;
+    }
+
+    ct->sub_threads[SA_N_PHASES] = NULL;
+    ct->domain->n_phases = SA_N_PHASES;
+}
+
+
+static void saRegisterDomain(Domain *d)	/* first domain is the active one */
+{
+    if(sa_domain == NULL)
+    {
+        sa_domain = d;
+    }
+}
+
+
+static Domain *saBuilderFinish(struct SaBuilder *b)
+{
+    Domain *d = (Domain*) saMalloc(sizeof(Domain));
+    Thread *ct, *fint, *fb[6], *tf;
+    int *face_partner, *face_cell, *face_zone, *face_index;
+    int *slots, hash_size, i, j, k, n, c, f, slot, side, n_interior;
+    int n_bfaces[6];
+    long long key[SA_MAX_FACE_NODES];
+    int sorted[SA_MAX_FACE_NODES];
+    unsigned long mask;
+    real lo[3], hi[3], fc[3], tol;
+    int p;
+
+    memset(d, 0, sizeof(Domain));
+
+    /* nodes */
+    d->n_nodes = b->n_nodes;
+    d->nodes = (Node*) saMalloc(b->n_nodes*sizeof(Node));
+
+    for(k = 0; k < 3; ++k)
+    {
+        lo[k] = 1e300;
+        hi[k] = -1e300;
+    }
+
+    for(i = 0; i < b->n_nodes; ++i)
+    {
+        for(k = 0; k < 3; ++k)
+        {
+            d->nodes[i].x[k] = b->x[3*i+k];
+            if(b->x[3*i+k] < lo[k]) lo[k] = b->x[3*i+k];
+            if(b->x[3*i+k] > hi[k]) hi[k] = b->x[3*i+k];
+        }
+        d->nodes[i].mark = 0;
+    }
+
+    /* match faces of different cells by their sorted node lists */
+    face_partner = (int*) saMalloc(b->n_faces*sizeof(int));
+    face_cell = (int*) saMalloc(b->n_faces*sizeof(int));
+    face_zone = (int*) saMalloc(b->n_faces*sizeof(int));
+    face_index = (int*) saMalloc(b->n_faces*sizeof(int));
+
+    for(c = 0; c < b->n_cells; ++c)
+    {
+        for(f = b->cell_face_offset[c]; f < b->cell_face_offset[c+1]; ++f)
+        {
+            face_cell[f] = c;
+            face_partner[f] = -1;
+        }
+    }
+
+    hash_size = 1024;
+
+    while(hash_size < 2*b->n_faces)
+    {
+        hash_size *= 2;
+    }
+
+    mask = (unsigned long) hash_size - 1;
+    slots = (int*) saMalloc(hash_size*sizeof(int));
+
+    for(i = 0; i < hash_size; ++i)
+    {
+        slots[i] = -1;
+    }
+
+    for(f = 0; f < b->n_faces; ++f)
+    {
+        n = b->face_node_offset[f+1] - b->face_node_offset[f];
+        memcpy(sorted, &b->face_nodes[b->face_node_offset[f]], n*sizeof(int));
+        qsort(sorted, n, sizeof(int), saCompareInt);
+
+        for(k = 0; k < n; ++k)
+        {
+            key[k] = sorted[k];
+        }
+
+        slot = (int) (saHashInts(key, n) & mask);
+
+        while((j = slots[slot]) != -1)
+        {
+            int nj = b->face_node_offset[j+1] - b->face_node_offset[j];
+            int sj[SA_MAX_FACE_NODES];
+
+            if(nj == n && face_partner[j] == -1)
+            {
+                memcpy(sj, &b->face_nodes[b->face_node_offset[j]], n*sizeof(int));
+                qsort(sj, n, sizeof(int), saCompareInt);
+
+                if(memcmp(sj, sorted, n*sizeof(int)) == 0)
+                {
+                    break;
+                }
+            }
+            slot = (int) ((slot + 1) & mask);
+        }
+
+        if(j != -1)
+        {
+            face_partner[j] = f;
+            face_partner[f] = j;
+        }
+        else
+        {
+            slots[slot] = f;
+        }
+    }
+
+    free(slots);
+
+    /* zones: interior (2) and boundary zones by bounding box side */
+    ct = saNewThread(d, SA_FLUID_ID, 1);
+    fint = saNewThread(d, SA_INTERIOR_ID, 0);
+
+    for(side = 0; side < 6; ++side)
+    {
+        fb[side] = saNewThread(d, SA_BOUNDARY_ID_XMIN + side, 0);
+        fb[side]->boundary = 1;
+        n_bfaces[side] = 0;
+    }
+
+    tol = b->quantum*10;
+    n_interior = 0;
+
+    for(f = 0; f < b->n_faces; ++f)
+    {
+        if(face_partner[f] >= 0)
+        {
+            if(face_partner[f] > f)
+            {
+                face_zone[f] = -1;
+                face_index[f] = n_interior;
+                face_zone[face_partner[f]] = -1;
+                face_index[face_partner[f]] = n_interior;
+                n_interior++;
+            }
+        }
+        else
+        {
+            n = b->face_node_offset[f+1] - b->face_node_offset[f];
+
+            for(k = 0; k < 3; ++k)
+            {
+                fc[k] = 0;
+                for(i = b->face_node_offset[f]; i < b->face_node_offset[f+1]; ++i)
+                {
+                    fc[k] += b->x[3*b->face_nodes[i]+k]/n;
+                }
+            }
+
+            side = 0;
+
+            for(k = 0; k < 3; ++k)
+            {
+                if(fabs(fc[k] - lo[k]) < tol)
+                {
+                    side = 2*k;
+                    break;
+                }
+                if(fabs(fc[k] - hi[k]) < tol)
+                {
+                    side = 2*k + 1;
+                    break;
+                }
+            }
+
+            face_zone[f] = side;
+            face_index[f] = n_bfaces[side]++;
+        }
+    }
+
+    fint->n_int = n_interior;
+    fint->f_c0 = (cell_t*) saMalloc(n_interior*sizeof(cell_t));
+    fint->f_c1 = (cell_t*) saMalloc(n_interior*sizeof(cell_t));
+    fint->t0 = ct;
+    fint->t1 = ct;
+    fint->f_id_offset = 1;
+
+    p = 1 + n_interior;
+
+    for(side = 0; side < 6; ++side)
+    {
+        fb[side]->n_int = n_bfaces[side];
+        fb[side]->f_c0 = (cell_t*) saMalloc(n_bfaces[side]*sizeof(cell_t));
+        fb[side]->f_c1 = (cell_t*) saMalloc(n_bfaces[side]*sizeof(cell_t));
+        fb[side]->t0 = ct;
+        fb[side]->t1 = NULL;
+        fb[side]->f_id_offset = p;
+        p += n_bfaces[side];
+    }
+
+    /* cell thread */
+    ct->n_int = b->n_cells;
+    ct->c_face_offset = (int*) saMalloc((b->n_cells + 1)*sizeof(int));
+    ct->c_face = (face_t*) saMalloc(b->n_faces*sizeof(face_t));
+    ct->c_face_thread = (Thread**) saMalloc(b->n_faces*sizeof(Thread*));
+
+    for(c = 0; c <= b->n_cells; ++c)
+    {
+        ct->c_face_offset[c] = b->cell_face_offset[c];
+    }
+
+    for(f = 0; f < b->n_faces; ++f)
+    {
+        c = face_cell[f];
+
+        if(face_zone[f] < 0)
+        {
+            tf = fint;
+
+            if(face_partner[f] > f)
+            {
+                tf->f_c0[face_index[f]] = c;
+                tf->f_c1[face_index[f]] = face_cell[face_partner[f]];
+            }
+        }
+        else
+        {
+            tf = fb[face_zone[f]];
+            tf->f_c0[face_index[f]] = c;
+            tf->f_c1[face_index[f]] = -1;
+        }
+
+        ct->c_face[f] = face_index[f];
+        ct->c_face_thread[f] = tf;
+    }
+
+    /* cell nodes (unique), volumes and centroids */
+    ct->c_node_offset = (int*) saMalloc((b->n_cells + 1)*sizeof(int));
+    ct->c_node = (Node**) saMalloc(b->n_face_nodes*sizeof(Node*));
+    ct->volume = (real*) saMalloc(b->n_cells*sizeof(real));
+    ct->centroid = (real*) saMalloc(ND_ND*b->n_cells*sizeof(real));
+    ct->c_node_offset[0] = 0;
+    p = 0;
+
+    for(c = 0; c < b->n_cells; ++c)
+    {
+        real cc[3] = {0, 0, 0};
+        real vol = 0, xc[3] = {0, 0, 0};
+        int first = p;
+
+        for(f = b->cell_face_offset[c]; f < b->cell_face_offset[c+1]; ++f)
+        {
+            for(i = b->face_node_offset[f]; i < b->face_node_offset[f+1]; ++i)
+            {
+                Node *v = &d->nodes[b->face_nodes[i]];
+
+                for(j = first; j < p; ++j)
+                {
+                    if(ct->c_node[j] == v)
+                    {
+                        break;
+                    }
+                }
+
+                if(j == p)
+                {
+                    ct->c_node[p++] = v;
+                    for(k = 0; k < 3; ++k)
+                    {
+                        cc[k] += v->x[k];
+                    }
+                }
+            }
+        }
+
+        ct->c_node_offset[c+1] = p;
+
+        for(k = 0; k < 3; ++k)
+        {
+            cc[k] /= (p - first);
+        }
+
+        /* volume from tetrahedra (cell center, face center, face edge) */
+        for(f = b->cell_face_offset[c]; f < b->cell_face_offset[c+1]; ++f)
+        {
+            n = b->face_node_offset[f+1] - b->face_node_offset[f];
+
+            for(k = 0; k < 3; ++k)
+            {
+                fc[k] = 0;
+                for(i = 0; i < n; ++i)
+                {
+                    fc[k] += b->x[3*b->face_nodes[b->face_node_offset[f]+i]+k]/n;
+                }
+            }
+
+            for(i = 0; i < n; ++i)
+            {
+                const real *xa = &b->x[3*b->face_nodes[b->face_node_offset[f]+i]];
+                const real *xb = &b->x[3*b->face_nodes[b->face_node_offset[f]+(i+1)%n]];
+                real u[3], v[3], w[3], tv;
+
+                for(k = 0; k < 3; ++k)
+                {
+                    u[k] = xa[k] - cc[k];
+                    v[k] = xb[k] - cc[k];
+                    w[k] = fc[k] - cc[k];
+                }
+
+                tv = fabs(u[0]*(v[1]*w[2] - v[2]*w[1]) - u[1]*(v[0]*w[2] - v[2]*w[0])
+                          + u[2]*(v[0]*w[1] - v[1]*w[0]))/6.0;
+                vol += tv;
+
+                for(k = 0; k < 3; ++k)
+                {
+                    xc[k] += tv*(cc[k] + xa[k] + xb[k] + fc[k])/4.0;
+                }
+            }
+        }
+
+        ct->volume[c] = vol;
+
+        for(k = 0; k < 3; ++k)
+        {
+            ct->centroid[ND_ND*c+k] = xc[k]/vol;
+        }
+    }
+
+    saInitCellData(ct);
+
+    free(face_partner);
+    free(face_cell);
+    free(face_zone);
+    free(face_index);
+
+    free(b->x);
+    free(b->node_keys);
+    free(b->node_slots);
+    free(b->cell_face_offset);
+    free(b->face_node_offset);
+    free(b->face_nodes);
+
+    saRegisterDomain(d);
+
+    return d;
+}
+
+/* ------------------------------------------------------------------------- */
+/* generators */
+
+static void saCornerOfHex(real h, int i, int j, int k, int corner, real x[3])
+{
+    x[0] = h*(i + ((corner >> 0) & 1));
+    x[1] = h*(j + ((corner >> 1) & 1));
+    x[2] = h*(k + ((corner >> 2) & 1));
+}
+
+
+Domain *saBuildHexMesh(int nx, int ny, int nz, real h)
+{
+/*
+    Structured grid assembled directly (no face matching), same numbering of
+    cells, faces and zones as the generic builder but fast enough for
+    benchmark meshes with 1e7 cells and more
+*/
+    static const int order[8] = {0, 2, 6, 4, 1, 5, 7, 3};   /* cell nodes */
+    Domain *d = (Domain*) saMalloc(sizeof(Domain));
+    Thread *ct, *fint, *fb[6];
+    size_t n_cells = (size_t) nx*ny*nz;
+    size_t c, n, f_int, f;
+    int *plus[3];           /* interior face on the + side per direction */
+    int n_bfaces[6], dim[3];
+    int i, j, k, q, side, p;
+
+    if(n_cells*6 > (size_t) INT_MAX)
+    {
+        fprintf(stderr, "saBuildHexMesh: %ix%ix%i cells exceed the int face index\n",
+                nx, ny, nz);
+        exit(EXIT_FAILURE);
+    }
+
+    memset(d, 0, sizeof(Domain));
+    dim[0] = nx;
+    dim[1] = ny;
+    dim[2] = nz;
+
+    /* nodes */
+    d->n_nodes = (nx + 1)*(ny + 1)*(nz + 1);
+    d->nodes = (Node*) saMalloc((size_t) d->n_nodes*sizeof(Node));
+    n = 0;
+
+    for(k = 0; k <= nz; ++k)
+    for(j = 0; j <= ny; ++j)
+    for(i = 0; i <= nx; ++i)
+    {
+        d->nodes[n].x[0] = h*i;
+        d->nodes[n].x[1] = h*j;
+        d->nodes[n].x[2] = h*k;
+        d->nodes[n].mark = 0;
+        ++n;
+    }
+
+    /* zones */
+    ct = saNewThread(d, SA_FLUID_ID, 1);
+    fint = saNewThread(d, SA_INTERIOR_ID, 0);
+
+    for(side = 0; side < 6; ++side)
+    {
+        fb[side] = saNewThread(d, SA_BOUNDARY_ID_XMIN + side, 0);
+        fb[side]->boundary = 1;
+        fb[side]->n_int = (dim[0]*dim[1]*dim[2])/dim[side/2];
+        n_bfaces[side] = 0;
+    }
+
+    fint->n_int = (nx - 1)*ny*nz + nx*(ny - 1)*nz + nx*ny*(nz - 1);
+    fint->f_c0 = (cell_t*) saMalloc((size_t) fint->n_int*sizeof(cell_t));
+    fint->f_c1 = (cell_t*) saMalloc((size_t) fint->n_int*sizeof(cell_t));
+    fint->t0 = ct;
+    fint->t1 = ct;
+    fint->f_id_offset = 1;
+
+    p = 1 + fint->n_int;
+
+    for(side = 0; side < 6; ++side)
+    {
+        fb[side]->f_c0 = (cell_t*) saMalloc((size_t) fb[side]->n_int*sizeof(cell_t));
+        fb[side]->f_c1 = (cell_t*) saMalloc((size_t) fb[side]->n_int*sizeof(cell_t));
+        fb[side]->t0 = ct;
+        fb[side]->t1 = NULL;
+        fb[side]->f_id_offset = p;
+        p += fb[side]->n_int;
+    }
+
+    /* interior faces numbered by their lower cell (x+, y+, z+ per cell) */
+    for(q = 0; q < 3; ++q)
+    {
+        plus[q] = (int*) saMalloc(n_cells*sizeof(int));
+    }
+
+    f_int = 0;
+    c = 0;
+
+    for(k = 0; k < nz; ++k)
+    for(j = 0; j < ny; ++j)
+    for(i = 0; i < nx; ++i)
+    {
+        int ijk[3];
+        size_t stride[3];
+
+        ijk[0] = i;
+        ijk[1] = j;
+        ijk[2] = k;
+        stride[0] = 1;
+        stride[1] = nx;
+        stride[2] = (size_t) nx*ny;
+
+        for(q = 0; q < 3; ++q)
+        {
+            plus[q][c] = -1;
+
+            if(ijk[q] + 1 < dim[q])
+            {
+                fint->f_c0[f_int] = (cell_t) c;
+                fint->f_c1[f_int] = (cell_t) (c + stride[q]);
+                plus[q][c] = (int) f_int++;
+            }
+        }
+        ++c;
+    }
+
+    /* cell faces, nodes, volumes and centroids */
+    ct->n_int = (int) n_cells;
+    ct->c_face_offset = (int*) saMalloc((n_cells + 1)*sizeof(int));
+    ct->c_face = (face_t*) saMalloc(6*n_cells*sizeof(face_t));
+    ct->c_face_thread = (Thread**) saMalloc(6*n_cells*sizeof(Thread*));
+    ct->c_node_offset = (int*) saMalloc((n_cells + 1)*sizeof(int));
+    ct->c_node = (Node**) saMalloc(8*n_cells*sizeof(Node*));
+    ct->volume = (real*) saMalloc(n_cells*sizeof(real));
+    ct->centroid = (real*) saMalloc(ND_ND*n_cells*sizeof(real));
+    ct->c_face_offset[0] = 0;
+    ct->c_node_offset[0] = 0;
+    c = 0;
+
+    for(k = 0; k < nz; ++k)
+    for(j = 0; j < ny; ++j)
+    for(i = 0; i < nx; ++i)
+    {
+        int ijk[3];
+        size_t stride[3];
+        size_t node0 = (size_t) i + (size_t) (nx + 1)*(j + (size_t) (ny + 1)*k);
+
+        ijk[0] = i;
+        ijk[1] = j;
+        ijk[2] = k;
+        stride[0] = 1;
+        stride[1] = nx;
+        stride[2] = (size_t) nx*ny;
+        f = 6*c;
+
+        for(q = 0; q < 3; ++q)
+        {
+            /* - side */
+            if(ijk[q] > 0)
+            {
+                ct->c_face[f] = plus[q][c - stride[q]];
+                ct->c_face_thread[f] = fint;
+            }
+            else
+            {
+                ct->c_face[f] = n_bfaces[2*q];
+                ct->c_face_thread[f] = fb[2*q];
+                fb[2*q]->f_c0[n_bfaces[2*q]] = (cell_t) c;
+                fb[2*q]->f_c1[n_bfaces[2*q]++] = -1;
+            }
+            ++f;
+
+            /* + side */
+            if(plus[q][c] >= 0)
+            {
+                ct->c_face[f] = plus[q][c];
+                ct->c_face_thread[f] = fint;
+            }
+            else
+            {
+                ct->c_face[f] = n_bfaces[2*q+1];
+                ct->c_face_thread[f] = fb[2*q+1];
+                fb[2*q+1]->f_c0[n_bfaces[2*q+1]] = (cell_t) c;
+                fb[2*q+1]->f_c1[n_bfaces[2*q+1]++] = -1;
+            }
+            ++f;
+        }
+
+        for(q = 0; q < 8; ++q)
+        {
+            ct->c_node[8*c+q] = &d->nodes[node0 + ((order[q] >> 0) & 1)
+                                + (size_t) (nx + 1)*(((order[q] >> 1) & 1)
+                                + (size_t) (ny + 1)*((order[q] >> 2) & 1))];
+        }
+
+        ct->c_face_offset[c+1] = (int) (6*(c + 1));
+        ct->c_node_offset[c+1] = (int) (8*(c + 1));
+        ct->volume[c] = h*h*h;
+        ct->centroid[ND_ND*c+0] = h*(i + 0.5);
+        ct->centroid[ND_ND*c+1] = h*(j + 0.5);
+        ct->centroid[ND_ND*c+2] = h*(k + 0.5);
+        ++c;
+    }
+
+    for(q = 0; q < 3; ++q)
+    {
+        free(plus[q]);
+    }
+
+    saInitCellData(ct);
+    saRegisterDomain(d);
+
+    return d;
+}
+
+
+Domain *saBuildTetMesh(int nx, int ny, int nz, real h)
+{
+    static const int perms[6][3] = {
+        {0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}
+    };
+    static const int tris[4][3] = {{0, 1, 2}, {0, 1, 3}, {0, 2, 3}, {1, 2, 3}};
+    struct SaBuilder b;
+    real tet[4][3], face[3][3];
+    int i, j, k, p, q, n, corner;
+
+    saBuilderInit(&b, h, (nx + 1)*(ny + 1)*(nz + 1));
+
+    for(k = 0; k < nz; ++k)
+    for(j = 0; j < ny; ++j)
+    for(i = 0; i < nx; ++i)
+    {
+        for(p = 0; p < 6; ++p)
+        {
+            /* path 000 -> 111 along the axes in order perms[p] */
+            corner = 0;
+            saCornerOfHex(h, i, j, k, corner, tet[0]);
+
+            for(q = 0; q < 3; ++q)
+            {
+                corner |= 1 << perms[p][q];
+                saCornerOfHex(h, i, j, k, corner, tet[q+1]);
+            }
+
+            for(q = 0; q < 4; ++q)
+            {
+                for(n = 0; n < 3; ++n)
+                {
+                    memcpy(face[n], tet[tris[q][n]], sizeof(face[n]));
+                }
+                saBuilderAddFace(&b, face, 3);
+            }
+
+            saBuilderEndCell(&b);
+        }
+    }
+
+    return saBuilderFinish(&b);
+}
+
+
+Domain *saBuildPolyMesh(int nx, int ny, int nz, real h)
+{
+    struct SaBuilder b;
+    real r = h/sqrt(3.0);               /* hexagon circumradius, width = h */
+    real ring[6][2], cx, cy, face[6][3], side[4][3];
+    int i, j, k, q;
+
+    saBuilderInit(&b, h, 4*(nx + 1)*(ny + 1)*(nz + 1));
+
+    for(k = 0; k < nz; ++k)
+    for(j = 0; j < ny; ++j)
+    for(i = 0; i < nx; ++i)
+    {
+        cx = h*(i + 0.5*(j & 1));
+        cy = 1.5*r*j;
+
+        for(q = 0; q < 6; ++q)
+        {
+            ring[q][0] = cx + r*cos(M_PI/6.0 + q*M_PI/3.0);
+            ring[q][1] = cy + r*sin(M_PI/6.0 + q*M_PI/3.0);
+        }
+
+        for(q = 0; q < 6; ++q)              /* bottom */
+        {
+            face[q][0] = ring[q][0];
+            face[q][1] = ring[q][1];
+            face[q][2] = h*k;
+        }
+        saBuilderAddFace(&b, face, 6);
+
+        for(q = 0; q < 6; ++q)              /* top */
+        {
+            face[q][2] = h*(k + 1);
+        }
+        saBuilderAddFace(&b, face, 6);
+
+        for(q = 0; q < 6; ++q)              /* sides */
+        {
+            side[0][0] = ring[q][0];       side[0][1] = ring[q][1];       side[0][2] = h*k;
+            side[1][0] = ring[(q+1)%6][0]; side[1][1] = ring[(q+1)%6][1]; side[1][2] = h*k;
+            side[2][0] = ring[(q+1)%6][0]; side[2][1] = ring[(q+1)%6][1]; side[2][2] = h*(k+1);
+            side[3][0] = ring[q][0];       side[3][1] = ring[q][1];       side[3][2] = h*(k+1);
+            saBuilderAddFace(&b, side, 4);
+        }
+
+        saBuilderEndCell(&b);
+    }
+
+    return saBuilderFinish(&b);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void saSetVof(Domain *d, int phase, real (*alpha)(const real x[ND_ND], void *ctx),
+                void *ctx)
+{
+    Thread *ct = d->c;
+    real *vof0 = ct->sub_threads[phase]->storage[SV_VOF];
+    real *vof1 = ct->sub_threads[1 - phase]->storage[SV_VOF];
+    real x[ND_ND];
+    cell_t c;
+
+    begin_c_loop(c, ct)
+    {
+        C_CENTROID(x, c, ct);
+        vof0[c] = alpha(x, ctx);
+        vof1[c] = 1.0 - vof0[c];
+    }
+    end_c_loop(c, ct)
+}
+
+
+void saFreeDomain(Domain *d)
+{
+    Thread *t, *next;
+    int p, s;
+
+    if(d == NULL)
+    {
+        return;
+    }
+
+    for(t = d->c; t != NULL; t = next)
+    {
+        next = t->next;
+
+        if(t->sub_threads != NULL)
+        {
+            for(p = 0; t->sub_threads[p] != NULL; ++p)
+            {
+                for(s = 0; s < SA_SV_MAX; ++s)
+                {
+                    free(t->sub_threads[p]->storage[s]);
+                }
+                free(t->sub_threads[p]);
+            }
+            free(t->sub_threads);
+        }
+
+        free(t->volume);
+        free(t->centroid);
+        free(t->part);
+        free(t->cid);
+        free(t->udm);
+        free(t->c_face_offset);
+        free(t->c_face);
+        free(t->c_face_thread);
+        free(t->c_node_offset);
+        free(t->c_node);
+        free(t);
+    }
+
+    for(t = d->f; t != NULL; t = next)
+    {
+        next = t->next;
+        free(t->f_c0);
+        free(t->f_c1);
+        free(t->f_gid);
+        free(t);
+    }
+
+    free(d->nodes);
+
+    if(sa_domain == d)
+    {
+        sa_domain = NULL;
+    }
+
+    free(d);
+}
+
+
+void saSetActiveDomain(Domain *d)
+{
+    sa_domain = d;
+}
+
+/* ------------------------------------------------------------------------- */
+/* partitions */
+
+Domain *saPartitionDomain(Domain *d, int no_ranks, int rank)
+{
+/*
+    Partition rank of no_ranks of the serial mesh d, like a compute node of a
+    parallel Fluent session holds it: the interior cells are a contiguous 
+    block of the cell numbering (slabs along z for the generators), the 
+    exterior cells are all cells of other partitions sharing a node with an 
+    interior cell (C_PART: their partition). Cells keep their index in d as 
+    C_ID, faces keep their F_ID. Only faces of interior cells are kept, so 
+    exterior cells only know the faces shared with interior cells. The cell 
+    data (VOF, UDMs) is copied from d.
+*/
+    Domain *ld = (Domain*) saMalloc(sizeof(Domain));
+    Thread *ct = d->c;
+    Thread *lct, *tf, *ltf;
+    int n_cells = ct->n_int;
+    int *owner, *local, *node_offset, *node_cells, *face_map[SA_MAX_ZONES];
+    Thread *face_thread[SA_MAX_ZONES];
+    int c, lc, n, v, i, j, k, p, f, lf, z, no_zones;
+
+    memset(ld, 0, sizeof(Domain));
+    ld->n_phases = d->n_phases;
+    ld->n_nodes = d->n_nodes;
+    ld->nodes = (Node*) saMalloc((size_t) d->n_nodes*sizeof(Node));
+    memcpy(ld->nodes, d->nodes, (size_t) d->n_nodes*sizeof(Node));
+
+    owner = (int*) saMalloc(n_cells*sizeof(int));
+    local = (int*) saMalloc(n_cells*sizeof(int));
+
+    for(c = 0; c < n_cells; ++c)
+    {
+        owner[c] = (int) (((long long) c*no_ranks)/n_cells);
+        local[c] = -1;
+    }
+
+    /* cells of every node */
+    node_offset = (int*) saMalloc((d->n_nodes + 1)*sizeof(int));
+    node_cells = (int*) saMalloc(ct->c_node_offset[n_cells]*sizeof(int));
+    memset(node_offset, 0, (d->n_nodes + 1)*sizeof(int));
+
+    for(i = 0; i < ct->c_node_offset[n_cells]; ++i)
+    {
+        node_offset[(ct->c_node[i] - d->nodes) + 1]++;
+    }
+
+    for(v = 0; v < d->n_nodes; ++v)
+    {
+        node_offset[v+1] += node_offset[v];
+    }
+
+    for(c = 0; c < n_cells; ++c)
+    {
+        for(i = ct->c_node_offset[c]; i < ct->c_node_offset[c+1]; ++i)
+        {
+            v = (int) (ct->c_node[i] - d->nodes);
+            node_cells[node_offset[v]++] = c;
+        }
+    }
+
+    for(v = d->n_nodes; v > 0; --v)
+    {
+        node_offset[v] = node_offset[v-1];
+    }
+    node_offset[0] = 0;
+
+    /* interior cells first, then the exterior cells in the order of d */
+    lct = saNewThread(ld, ct->id, 1);
+    n = 0;
+
+    for(c = 0; c < n_cells; ++c)
+    {
+        if(owner[c] == rank)
+        {
+            local[c] = n++;
+        }
+    }
+
+    lct->n_int = n;
+
+    for(c = 0; c < n_cells; ++c)
+    {
+        if(owner[c] != rank)
+        {
+            continue;
+        }
+
+        for(i = ct->c_node_offset[c]; i < ct->c_node_offset[c+1]; ++i)
+        {
+            v = (int) (ct->c_node[i] - d->nodes);
+
+            for(j = node_offset[v]; j < node_offset[v+1]; ++j)
+            {
+                if(local[node_cells[j]] == -1)
+                {
+                    local[node_cells[j]] = -2;
+                }
+            }
+        }
+    }
+
+    for(c = 0; c < n_cells; ++c)
+    {
+        if(local[c] == -2)
+        {
+            local[c] = n++;
+        }
+    }
+
+    lct->n_ext = n - lct->n_int;
+    lct->volume = (real*) saMalloc(n*sizeof(real));
+    lct->centroid = (real*) saMalloc(ND_ND*n*sizeof(real));
+    saInitCellData(lct);
+
+    for(c = 0; c < n_cells; ++c)
+    {
+        lc = local[c];
+
+        if(lc < 0)
+        {
+            continue;
+        }
+
+        lct->part[lc] = owner[c];
+        lct->cid[lc] = c;
+        lct->volume[lc] = ct->volume[c];
+
+        for(k = 0; k < ND_ND; ++k)
+        {
+            lct->centroid[ND_ND*lc + k] = ct->centroid[ND_ND*c + k];
+        }
+
+        for(k = 0; k < SA_MAX_UDM; ++k)
+        {
+            lct->udm[(size_t) lc*SA_MAX_UDM + k] = ct->udm[(size_t) c*SA_MAX_UDM + k];
+        }
+
+        for(p = 0; p < SA_N_PHASES; ++p)
+        {
+            for(k = 0; k < SA_SV_MAX; ++k)
+            {
+                lct->sub_threads[p]->storage[k][lc] = ct->sub_threads[p]->storage[k][c];
+            }
+        }
+    }
+
+    /* face zones: faces with an interior cell */
+    no_zones = 0;
+
+    thread_loop_f(tf, d)
+    {
+        if(no_zones == SA_MAX_ZONES)
+        {
+            fprintf(stderr, "saPartitionDomain: more than %i face zones\n", SA_MAX_ZONES);
+            exit(EXIT_FAILURE);
+        }
+
+        ltf = saNewThread(ld, tf->id, 0);
+        ltf->boundary = tf->boundary;
+        ltf->t0 = lct;
+        ltf->t1 = (tf->t1 != NULL) ? lct : NULL;
+        face_map[no_zones] = (int*) saMalloc((tf->n_int + 1)*sizeof(int));
+        face_thread[no_zones] = ltf;
+        n = 0;
+
+        for(f = 0; f < tf->n_int; ++f)
+        {
+            face_map[no_zones][f] = -1;
+
+            if(owner[tf->f_c0[f]] == rank 
+                || (tf->f_c1[f] >= 0 && owner[tf->f_c1[f]] == rank))
+            {
+                face_map[no_zones][f] = n++;
+            }
+        }
+
+        ltf->n_int = n;
+        ltf->f_c0 = (cell_t*) saMalloc(n*sizeof(cell_t));
+        ltf->f_c1 = (cell_t*) saMalloc(n*sizeof(cell_t));
+        ltf->f_gid = (int*) saMalloc(n*sizeof(int));
+
+        for(f = 0; f < tf->n_int; ++f)
+        {
+            lf = face_map[no_zones][f];
+
+            if(lf >= 0)
+            {
+                ltf->f_c0[lf] = local[tf->f_c0[f]];
+                ltf->f_c1[lf] = (tf->f_c1[f] >= 0) ? local[tf->f_c1[f]] : -1;
+                ltf->f_gid[lf] = F_ID(f, tf);
+            }
+        }
+
+        no_zones++;
+    }
+
+    /* faces and nodes of the local cells */
+    lct->c_face_offset = (int*) saMalloc((lct->n_int + lct->n_ext + 1)*sizeof(int));
+    lct->c_face = (face_t*) saMalloc(ct->c_face_offset[n_cells]*sizeof(face_t));
+    lct->c_face_thread = (Thread**) saMalloc(ct->c_face_offset[n_cells]*sizeof(Thread*));
+    lct->c_node_offset = (int*) saMalloc((lct->n_int + lct->n_ext + 1)*sizeof(int));
+    lct->c_node = (Node**) saMalloc(ct->c_node_offset[n_cells]*sizeof(Node*));
+    lct->c_face_offset[0] = 0;
+    lct->c_node_offset[0] = 0;
+    i = 0;
+    j = 0;
+
+    for(lc = 0; lc < lct->n_int + lct->n_ext; ++lc)
+    {
+        c = lct->cid[lc];
+
+        for(k = ct->c_face_offset[c]; k < ct->c_face_offset[c+1]; ++k)
+        {
+            for(z = 0; z < no_zones && face_thread[z]->id != ct->c_face_thread[k]->id; ++z);
+
+            lf = face_map[z][ct->c_face[k]];
+
+            if(lf >= 0)
+            {
+                lct->c_face[i] = lf;
+                lct->c_face_thread[i] = face_thread[z];
+                i++;
+            }
+        }
+
+        for(k = ct->c_node_offset[c]; k < ct->c_node_offset[c+1]; ++k)
+        {
+            lct->c_node[j++] = ld->nodes + (ct->c_node[k] - d->nodes);
+        }
+
+        lct->c_face_offset[lc+1] = i;
+        lct->c_node_offset[lc+1] = j;
+    }
+
+    for(z = 0; z < no_zones; ++z)
+    {
+        free(face_map[z]);
+    }
+
+    free(owner);
+    free(local);
+    free(node_offset);
+    free(node_cells);
+
+    return ld;
+}
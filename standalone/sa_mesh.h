@@ -0,0 +1,30 @@
+/*
+Mesh generators and session helpers of the standalone Fluent stand-in.
+ */
+
+#ifndef SA_MESH_H
+#define SA_MESH_H
+
+#include "udf.h"
+
+#define SA_FLUID_ID 1
+#define SA_INTERIOR_ID 2
+#define SA_BOUNDARY_ID_XMIN 3           /* xmin, xmax, ymin, ymax, zmin, zmax */
+#define SA_N_PHASES 2
+#define SA_LIQUID_DENSITY 998.2
+#define SA_GAS_DENSITY 1.225
+#define SA_MAX_ZONES 16                 /* face zones of a partition */
+
+extern int sa_quiet;                    /* suppress Message() output */
+
+Domain *saBuildHexMesh(int nx, int ny, int nz, real h);
+Domain *saBuildTetMesh(int nx, int ny, int nz, real h);
+Domain *saBuildPolyMesh(int nx, int ny, int nz, real h);
+void saSetVof(Domain *d, int phase, real (*alpha)(const real x[ND_ND], void *ctx),
+                void *ctx);
+void saSetActiveDomain(Domain *d);
+int saSetRpVar(const char *name, const char *value);
+void saFreeDomain(Domain *d);
+Domain *saPartitionDomain(Domain *d, int no_ranks, int rank);
+
+#endif
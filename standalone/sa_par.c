@@ -0,0 +1,268 @@
+/*
+Compute nodes of the udf.h stand-in (SA_PARALLEL=1): every compute node is a
+forked process, the messages of PRF_CSEND / PRF_CRECV go through one pipe per
+pair of compute nodes. Sends block like synchronous MPI sends once the pipe
+is full, so a compute node waiting for a message which is never sent hangs
+like it would in Fluent: saParRun() stops such runs with an alarm and
+reports them. Every message carries its tag and size, a receive of another
+message than the next one sent (a compute node which left a collective
+exchange early) stops the compute node as well.
+
+Built with FAIL_FLAGS (see Makefile) the allocations of the library go
+through saFailNext(), so a test can make a single allocation of one compute
+node fail (saParFailAlloc()) and check that all compute nodes still finish.
+ */
+
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "udf.h"
+#include "sa_par.h"
+
+static int sa_pipes[SA_MAX_RANKS][SA_MAX_RANKS][2];     /* [from][to] */
+static long sa_fail_countdown = 0;      /* allocations until the failing one */
+static int sa_fail_done = 0;
+
+
+void saParFailAlloc(long k)	/* the k-th allocation from now on fails, 0: none */
+{
+    sa_fail_countdown = k;
+    sa_fail_done = 0;
+}
+
+
+int saParFailDone(void)
+{
+    return sa_fail_done;
+}
+
+
+int saFailNext(void)	/* 1 if the next allocation fails */
+{
+    if(sa_fail_countdown > 0 && --sa_fail_countdown == 0)
+    {
+        sa_fail_done = 1;
+        return 1;
+    }
+
+    return 0;
+}
+
+
+void *saFailMalloc(size_t size)
+{
+    return saFailNext() ? NULL : malloc(size);
+}
+
+
+void *saFailCalloc(size_t n, size_t size)
+{
+    return saFailNext() ? NULL : calloc(n, size);
+}
+
+
+void *saFailRealloc(void *p, size_t size)
+{
+    return saFailNext() ? NULL : realloc(p, size);
+}
+
+
+static void saParWrite(int to, const void *buf, size_t bytes)
+{
+    const char *p = (const char*) buf;
+    ssize_t w;
+
+    while(bytes > 0)
+    {
+        w = write(sa_pipes[myid][to][1], p, bytes);
+
+        if(w <= 0)
+        {
+            fprintf(stderr, "sa_par: send from %i to %i failed\n", myid, to);
+            exit(EXIT_FAILURE);
+        }
+
+        p += w;
+        bytes -= (size_t) w;
+    }
+}
+
+
+static void saParRead(int from, void *buf, size_t bytes)
+{
+    char *p = (char*) buf;
+    ssize_t r;
+
+    while(bytes > 0)
+    {
+        r = read(sa_pipes[from][myid][0], p, bytes);
+
+        if(r <= 0)
+        {
+            fprintf(stderr, "sa_par: receive of %i from %i failed\n", myid, from);
+            exit(EXIT_FAILURE);
+        }
+
+        p += r;
+        bytes -= (size_t) r;
+    }
+}
+
+
+void saParSend(int to, int tag, const void *buf, size_t bytes)
+{
+    long header[2];
+
+    header[0] = tag;
+    header[1] = (long) bytes;
+    saParWrite(to, header, sizeof(header));
+    saParWrite(to, buf, bytes);
+}
+
+
+void saParRecv(int from, int tag, void *buf, size_t bytes)
+{
+    long header[2];
+
+    saParRead(from, header, sizeof(header));
+
+    if(header[0] != tag || header[1] != (long) bytes)
+    {
+        fprintf(stderr, "sa_par: compute node %i expected %lu bytes with tag %i from %i, "
+                "got %li bytes with tag %li\n", myid, (unsigned long) bytes, tag, from,
+                header[1], header[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    saParRead(from, buf, bytes);
+}
+
+
+void saParReduceReal(real *v, int n, int op)	/* result on all compute nodes */
+{
+    real *w = (real*) malloc((n > 0 ? n : 1)*sizeof(real));
+    int i, k;
+
+    if(w == NULL)
+    {
+        fprintf(stderr, "sa_par: out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if(myid == node_zero)
+    {
+        for(i = 1; i < compute_node_count; ++i)
+        {
+            saParRecv(i, SA_TAG_REDUCE - op, w, n*sizeof(real));
+
+            for(k = 0; k < n; ++k)
+            {
+                if(op == SA_REDUCE_LOW && w[k] < v[k]) v[k] = w[k];
+                if(op == SA_REDUCE_HIGH && w[k] > v[k]) v[k] = w[k];
+                if(op == SA_REDUCE_SUM) v[k] += w[k];
+            }
+        }
+
+        for(i = 1; i < compute_node_count; ++i)
+        {
+            saParSend(i, SA_TAG_REDUCE - op, v, n*sizeof(real));
+        }
+    }
+    else
+    {
+        saParSend(node_zero, SA_TAG_REDUCE - op, v, n*sizeof(real));
+        saParRecv(node_zero, SA_TAG_REDUCE - op, v, n*sizeof(real));
+    }
+
+    free(w);
+}
+
+
+int saParLowInt(int x)
+{
+    real v = (real) x;
+
+    saParReduceReal(&v, 1, SA_REDUCE_LOW);
+
+    return (int) v;
+}
+
+
+int saParRun(int no_ranks, int timeout, int (*rank_main)(void *ctx), void *ctx)
+{
+/*
+    Run rank_main on no_ranks compute nodes (forked processes, myid set),
+    returns 0 if all of them returned 0 within timeout seconds
+*/
+    pid_t pid[SA_MAX_RANKS];
+    int i, j, status;
+    int failed = 0;
+
+    if(no_ranks < 1 || no_ranks > SA_MAX_RANKS)
+    {
+        fprintf(stderr, "sa_par: 1 to %i compute nodes\n", SA_MAX_RANKS);
+        return 1;
+    }
+
+    for(i = 0; i < no_ranks; ++i)
+    for(j = 0; j < no_ranks; ++j)
+    {
+        if(pipe(sa_pipes[i][j]) != 0)
+        {
+            perror("sa_par: pipe");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+
+    for(i = 0; i < no_ranks; ++i)
+    {
+        pid[i] = fork();
+
+        if(pid[i] < 0)
+        {
+            perror("sa_par: fork");
+            exit(EXIT_FAILURE);
+        }
+
+        if(pid[i] == 0)
+        {
+            myid = i;
+            node_zero = 0;
+            compute_node_count = no_ranks;
+            alarm(timeout);
+            status = rank_main(ctx);
+            fflush(stdout);
+            _exit(status != 0);
+        }
+    }
+
+    for(i = 0; i < no_ranks; ++i)
+    for(j = 0; j < no_ranks; ++j)
+    {
+        close(sa_pipes[i][j][0]);
+        close(sa_pipes[i][j][1]);
+    }
+
+    for(i = 0; i < no_ranks; ++i)
+    {
+        waitpid(pid[i], &status, 0);
+
+        if(WIFSIGNALED(status))
+        {
+            fprintf(stderr, "sa_par: compute node %i of %i stopped by signal %i%s\n", i,
+                    no_ranks, WTERMSIG(status),
+                    (WTERMSIG(status) == SIGALRM) ? " (hangs)" : "");
+            failed = 1;
+        }
+        else if(WEXITSTATUS(status) != 0)
+        {
+            fprintf(stderr, "sa_par: compute node %i of %i failed\n", i, no_ranks);
+            failed = 1;
+        }
+    }
+
+    return failed;
+}
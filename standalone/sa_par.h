@@ -0,0 +1,19 @@
+/*
+Compute nodes of the udf.h stand-in (SA_PARALLEL=1), see sa_par.c.
+ */
+
+#ifndef SA_PAR_H
+#define SA_PAR_H
+
+#include "udf.h"
+
+#define SA_MAX_RANKS 8
+
+int saParRun(int no_ranks, int timeout, int (*rank_main)(void *ctx), void *ctx);
+void saParFailAlloc(long k);
+int saParFailDone(void);
+void *saFailMalloc(size_t size);
+void *saFailCalloc(size_t n, size_t size);
+void *saFailRealloc(void *p, size_t size);
+
+#endif
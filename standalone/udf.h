@@ -0,0 +1,230 @@
+/*
+Stand-in for the ANSYS Fluent udf.h header, used to build and run the cpad
+UDF library outside of Fluent (see README.md in this folder).
+
+Only the macros and functions used by vof_droplet_detection.c are provided.
+They work on the in-memory unstructured mesh of sa_mesh.c and mimic a serial
+(single compute node) Fluent session. Built with SA_PARALLEL=1 they mimic the
+compute nodes of a parallel session instead: every compute node is a process
+holding one partition of the mesh, messages are sent over pipes (sa_par.c).
+ */
+
+#ifndef SA_UDF_H
+#define SA_UDF_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* ------------------------------------------------------------------------- */
+
+#define RP_DOUBLE 1
+#ifndef SA_PARALLEL
+#define SA_PARALLEL 0
+#endif
+
+#define RP_HOST 0
+#define RP_NODE SA_PARALLEL
+#define PARALLEL SA_PARALLEL
+#define RP_3D 1
+#define ND_ND 3
+
+typedef double real;
+typedef int cell_t;
+typedef int face_t;
+typedef int cxboolean;
+
+#define TRUE 1
+#define FALSE 0
+
+/* storage variables */
+#define SV_VOF 0
+#define SV_DENSITY 1
+#define SA_SV_MAX 2
+
+#define SA_MAX_PHASES 4
+
+typedef struct sa_node_struct
+{
+    real x[ND_ND];
+    int mark;
+} Node;
+
+typedef struct sa_domain_struct Domain;
+typedef struct sa_thread_struct Thread;
+
+struct sa_thread_struct
+{
+    int id;
+    int boundary;                       /* face threads: 1 if boundary zone */
+    int n_int;                          /* interior elements */
+    int n_ext;                          /* exterior elements (partitions only) */
+    Thread *next;
+    Domain *domain;
+
+    /* cell threads */
+    Thread **sub_threads;               /* phase threads */
+    real *storage[SA_SV_MAX];
+    real *volume;
+    real *centroid;                     /* ND_ND per cell */
+    int *part;
+    int *cid;
+    real *udm;
+    int *c_face_offset;
+    face_t *c_face;
+    Thread **c_face_thread;
+    int *c_node_offset;
+    Node **c_node;
+
+    /* face threads */
+    cell_t *f_c0;
+    cell_t *f_c1;
+    Thread *t0;
+    Thread *t1;
+    int f_id_offset;
+    int *f_gid;                         /* F_ID of the faces of a partition */
+};
+
+struct sa_domain_struct
+{
+    Thread *c;                          /* cell threads */
+    Thread *f;                          /* face threads */
+    Node *nodes;
+    int n_nodes;
+    int n_phases;
+};
+
+/* ------------------------------------------------------------------------- */
+/* globals */
+
+extern int myid;
+extern int node_zero;
+extern int compute_node_count;
+extern real sa_current_time;
+extern int sa_n_udm;
+
+#define CURRENT_TIME sa_current_time
+#define N_UDM sa_n_udm
+#define I_AM_NODE_ZERO_P (myid == node_zero)
+#define I_AM_NODE_HOST_P 0
+
+void Message(const char *fmt, ...);
+#if SA_PARALLEL
+#define Message0 if(myid != node_zero) {} else Message
+#else
+#define Message0 Message
+#endif
+Domain *Get_Domain(int id);
+Thread *Lookup_Thread(Domain *d, int id);
+#define DOMAIN_N_DOMAINS(d) ((d)->n_phases)
+
+/* RP variables, defined with saSetRpVar() (lists: values separated by blanks) */
+int RP_Variable_Exists_P(char *name);
+real RP_Get_Real(char *name);
+int RP_Get_Integer(char *name);
+char *RP_Get_String(char *name);
+int RP_Get_List_Length(char *name);
+int RP_Get_List_Ref_Int(char *name, int i);
+real RP_Get_List_Ref_Float(char *name, int i);
+
+/* ------------------------------------------------------------------------- */
+/* UDF definitions */
+
+#define DEFINE_ON_DEMAND(name) void name(void)
+#define DEFINE_EXECUTE_AT_END(name) void name(void)
+#define DEFINE_EXECUTE_AT_EXIT(name) void name(void)
+#define DEFINE_EXECUTE_AFTER_CASE(name, libname) void name(char *libname)
+#define DEFINE_EXECUTE_AFTER_DATA(name, libname) void name(char *libname)
+
+/* ------------------------------------------------------------------------- */
+/* threads and loops */
+
+#define THREAD_ID(t) ((t)->id)
+#define THREAD_N_ELEMENTS_INT(t) ((t)->n_int)
+#define THREAD_N_ELEMENTS_EXT(t) ((t)->n_ext)
+#define THREAD_N_ELEMENTS_EEXT(t) ((t)->n_ext)
+#define THREAD_N_ELEMENTS(t) ((t)->n_int + (t)->n_ext)
+#define THREAD_SUB_THREADS(t) ((t)->sub_threads)
+#define THREAD_SUB_THREAD(t, i) ((t)->sub_threads[i])
+#define THREAD_STORAGE(t, sv) ((t)->storage[sv])
+#define BOUNDARY_FACE_THREAD_P(t) ((t)->boundary)
+#define FLUID_THREAD_P(t) ((t)->volume != NULL)    /* all cell threads are fluid zones */
+
+#define thread_loop_c(t, d) for((t) = (d)->c; (t) != NULL; (t) = (t)->next)
+#define thread_loop_f(t, d) for((t) = (d)->f; (t) != NULL; (t) = (t)->next)
+
+#define begin_c_loop(c, t) for((c) = 0; (c) < (t)->n_int + (t)->n_ext; ++(c)) {
+#define end_c_loop(c, t) }
+#define begin_c_loop_int(c, t) for((c) = 0; (c) < (t)->n_int; ++(c)) {
+#define end_c_loop_int(c, t) }
+#define begin_c_loop_ext(c, t) for((c) = (t)->n_int; (c) < (t)->n_int + (t)->n_ext; ++(c)) {
+#define end_c_loop_ext(c, t) }
+#define begin_f_loop(f, t) for((f) = 0; (f) < (t)->n_int; ++(f)) {
+#define end_f_loop(f, t) }
+
+/* ------------------------------------------------------------------------- */
+/* cell macros */
+
+#define C_STORAGE_R(c, t, sv) ((t)->storage[sv][c])
+#define C_VOF(c, t) C_STORAGE_R(c, t, SV_VOF)
+#define C_R(c, t) C_STORAGE_R(c, t, SV_DENSITY)
+#define C_VOLUME(c, t) ((t)->volume[c])
+#define C_CENTROID(x, c, t) do { int _sa_k; \
+        for(_sa_k = 0; _sa_k < ND_ND; ++_sa_k) \
+            (x)[_sa_k] = (t)->centroid[ND_ND*(c) + _sa_k]; } while(0)
+#define C_PART(c, t) ((t)->part[c])
+#define C_ID(c, t) ((t)->cid[c])
+#define C_UDMI(c, t, i) ((t)->udm[(size_t) (c)*SA_MAX_UDM + (i)])
+#define SA_MAX_UDM 2
+
+#define C_NFACES(c, t) ((t)->c_face_offset[(c)+1] - (t)->c_face_offset[c])
+#define c_face_loop(c, t, n) for((n) = 0; (n) < C_NFACES(c, t); ++(n))
+#define C_FACE(c, t, n) ((t)->c_face[(t)->c_face_offset[c] + (n)])
+#define C_FACE_THREAD(c, t, n) ((t)->c_face_thread[(t)->c_face_offset[c] + (n)])
+
+#define C_NNODES(c, t) ((t)->c_node_offset[(c)+1] - (t)->c_node_offset[c])
+#define c_node_loop(c, t, n) for((n) = 0; (n) < C_NNODES(c, t); ++(n))
+#define C_NODE(c, t, n) ((t)->c_node[(t)->c_node_offset[c] + (n)])
+#define NODE_X(v) ((v)->x[0])
+#define NODE_Y(v) ((v)->x[1])
+#define NODE_Z(v) ((v)->x[2])
+#define NODE_MARK(v) ((v)->mark)
+
+/* ------------------------------------------------------------------------- */
+/* face macros */
+
+#define F_C0(f, t) ((t)->f_c0[f])
+#define F_C1(f, t) ((t)->f_c1[f])
+#define F_C0_THREAD(f, t) ((t)->t0)
+#define F_C1_THREAD(f, t) ((t)->t1)
+#define F_ID(f, t) (((t)->f_gid != NULL) ? (t)->f_gid[f] : (f) + (t)->f_id_offset)
+
+/* ------------------------------------------------------------------------- */
+/* message passing between compute nodes (SA_PARALLEL, see sa_par.c) */
+
+#if SA_PARALLEL
+void saParSend(int to, int tag, const void *buf, size_t bytes);
+void saParRecv(int from, int tag, void *buf, size_t bytes);
+void saParReduceReal(real *v, int n, int op);
+int saParLowInt(int x);
+int saFailNext(void);
+
+#define SA_REDUCE_LOW 0
+#define SA_REDUCE_HIGH 1
+#define SA_REDUCE_SUM 2
+#define SA_TAG_REDUCE (-1)              /* tags of the reductions: SA_TAG_REDUCE - op */
+
+#define PRF_CSEND_INT(to, buf, n, tag) saParSend((to), (tag), (buf), (size_t) (n)*sizeof(int))
+#define PRF_CRECV_INT(from, buf, n, tag) saParRecv((from), (tag), (buf), (size_t) (n)*sizeof(int))
+#define PRF_CSEND_REAL(to, buf, n, tag) saParSend((to), (tag), (buf), (size_t) (n)*sizeof(real))
+#define PRF_CRECV_REAL(from, buf, n, tag) saParRecv((from), (tag), (buf), \
+                                                    (size_t) (n)*sizeof(real))
+#define PRF_GRLOW(v, n, work) ((void) (work), saParReduceReal((v), (n), SA_REDUCE_LOW))
+#define PRF_GRHIGH(v, n, work) ((void) (work), saParReduceReal((v), (n), SA_REDUCE_HIGH))
+#define PRF_GRSUM(v, n, work) ((void) (work), saParReduceReal((v), (n), SA_REDUCE_SUM))
+#define PRF_GILOW1(x) saParLowInt(x)
+#define compute_node_loop_not_zero(i) for((i) = 1; (i) < compute_node_count; ++(i))
+#endif
+
+#endif
@@ -5,9 +5,33 @@ VoF (Volume of Fluid) ANSYS Fluent cases.
 Settings:
     _PHASE_IDX : Phase index phase which should be detected
     _MIN_VOL_FRAC : Lower Limit for detection
-    _DETECT_OVER_EDGES 1 : Detect connected areas over cell edges, 
-                           if 0 only over cell faces 
-    _FLUID_  1 : Id of Fluid Domain
+    _CONNECTIVITY : Detect connected areas over cell faces (CPA_CONNECT_FACE),
+                    cell edges (CPA_CONNECT_EDGE) or cell vertices 
+                    (CPA_CONNECT_VERTEX)
+    (_PHASE_IDX, _MIN_VOL_FRAC, _CONNECTIVITY and _FLUID_ are defaults, they
+    are overridden at runtime by the RP variables cpad/phases, 
+    cpad/min-vol-frac, cpad/connectivity and cpad/fluid-zones if defined, 
+    see example/cpad_settings.scm)
+    _ENGINE : Default labelling engine, seed and grow (CPA_ENGINE_FLOOD_FILL),
+              disjoint set forest (CPA_ENGINE_UNION_FIND) or update of the
+              labels of the last call (CPA_ENGINE_INCREMENTAL), can be changed
+              at runtime with CPAD_FLOOD_FILL_oD / CPAD_UNION_FIND_oD / 
+              CPAD_INCREMENTAL_oD
+    (_STITCH, _OUTPUT CPA_OUTPUT_BINARY, _ASYNC_OUTPUT, _PROFILE and _TRACK 
+    are off by default, turn them on below or pass e.g. -D_STITCH=1 to the 
+    compiler)
+    _STITCH : Merge cpas split by partition boundaries to global cpas on 
+              node 0 (written to cpa_global.txt / .bin)
+    _OUTPUT : Text files (CPA_OUTPUT_TEXT) or binary records (CPA_OUTPUT_BINARY),
+              convert binary files with example/postprocess/cpa_bin2txt.py
+    _ASYNC_OUTPUT : Write binary records in a background thread (POSIX 
+                    threads), the solver only waits if two records are pending
+    _PROFILE : Append per call timings and counters of the detection stages
+               (min / max / mean over all compute nodes) to cpa_profile.csv
+    _TRACK : Link the global cpas of consecutive calls to tracks with 
+             persistent ids (cpa_tracks.txt) and record breakup and 
+             coalescence events (cpa_events.txt), requires _STITCH
+    _FLUID_  1 : Id of Fluid Domain (cell zone)
 
 WARNING: THIS IS AN EARLY VERSION THERE MAY BE INEXPECTED BUGS!
 
@@ -44,11 +68,56 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "stdlib.h"
 #include "mem.h"
 #include "sg_mphase.h"
+#include <time.h>
+#include <limits.h>
+
+#ifdef _OPENMP                          /* multi-threaded detection */
+#include <omp.h>
+#define CPA_THREAD_NUM omp_get_thread_num()
+#define CPA_NUM_THREADS omp_get_num_threads()
+#define CPA_MAX_THREADS omp_get_max_threads()
+#else
+#define CPA_THREAD_NUM 0
+#define CPA_NUM_THREADS 1
+#define CPA_MAX_THREADS 1
+#endif
+
+#define CPA_CONNECT_FACE 0   /* cells sharing a face are connected */
+#define CPA_CONNECT_EDGE 1   /* ... sharing an edge (at least 2 nodes) */
+#define CPA_CONNECT_VERTEX 2 /* ... sharing a node */
+
+#define CPA_ENGINE_FLOOD_FILL 0  /* seed and grow over neighbor cells */
+#define CPA_ENGINE_UNION_FIND 1  /* disjoint set forest over faces */
+#define CPA_ENGINE_INCREMENTAL 2 /* labels of the last call, see cpaIncremental() */
+
+#define CPA_OUTPUT_TEXT 0    /* <myid>_cpa.txt, cpa_global.txt */
+#define CPA_OUTPUT_BINARY 1  /* <myid>_cpa.bin, cpa_global.bin, see writeCpasBinary() */
 
 /* Settings */
 #define _PHASE_IDX 0 /* for phase to detect droplets of */
 #define _MIN_VOL_FRAC 0.01 /* Lower Limit for phase detection */
-#define _DETECT_OVER_EDGES 0
+#define _CONNECTIVITY CPA_CONNECT_FACE /* FACE, EDGE or VERTEX */
+#define _ENGINE CPA_ENGINE_FLOOD_FILL  /* default, switch with CPAD_*_oD */
+#define _LABEL_UDM -1 /* first UDM for the cpa label of every cell, -1: no labels */
+#define _STATS_ONLY 0 /* flood fill without cell lists (no track overlaps) */
+
+/* opt-in, set here or compile with e.g. -D_STITCH=1 -D_TRACK=1 
+   -D_OUTPUT=CPA_OUTPUT_BINARY */
+#ifndef _STITCH
+#define _STITCH 0 /* merge partition fragments to global cpas on node 0 */
+#endif
+#ifndef _OUTPUT
+#define _OUTPUT CPA_OUTPUT_TEXT /* TEXT or BINARY */
+#endif
+#ifndef _ASYNC_OUTPUT
+#define _ASYNC_OUTPUT 0 /* binary records are written by a background thread */
+#endif
+#ifndef _PROFILE
+#define _PROFILE 0 /* stage timings of all compute nodes to cpa_profile.csv */
+#endif
+#ifndef _TRACK
+#define _TRACK 0 /* persistent ids of global cpas over time (requires _STITCH) */
+#endif
 
 #define _FLUID_  1
 /* ------------------------------------------------------------------------- */
@@ -56,13 +125,38 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define _MYDEBUG 1
 #define STATE_OK 1
 #define STATE_ERROR 0
-#define MIN_UDMI 1
-#define UDMI_INT_TOL 1E-8
 #define STRLENMAX 50
 
-#define CELL_CHECKED 1
-#define NO_MAX_CELL_EDGE_NEIGHBOR_CELLS 80
 #define NO_MAX_CELL_FACE_NEIGHBOR_CELLS 30
+
+#define CPA_ARENA_BLOCK_SIZE 1048576  /* first arena block in bytes */
+#ifndef CPA_ALLOC_FAILS
+#define CPA_ALLOC_FAILS() 0           /* tests: make an arena allocation fail */
+#endif
+#define CPA_ARENA_ALIGNMENT 16
+#define CPA_MIN_LIST_CAPACITY 8
+#define CPA_SET_MIN_HASH 16           /* longer boundary / partition lists are hashed */
+#define CPA_MAX_CACHED_THREADS 16     /* cell threads with cached adjacency */
+#define CPA_MAX_CACHED_LABELS 32      /* cell thread / phase pairs of the incremental engine */
+#define CPA_OMP_MIN_CELLS 100000      /* smaller zones are labelled single-threaded */
+#define CPA_OMP_BIG_CPA_CELLS 65536   /* larger cpas are reduced by all threads */
+#define CPA_REDUCE_CHUNK 256          /* cells per block of the property reduction */
+#define CPA_MIN_QUEUE_CAPACITY 1024   /* fill queue of cpaFloodFillStats(), power of 2 */
+#define CPA_BIN_VERSION 1             /* binary record format version */
+#define CPA_BIN_HEADER_BYTES 48
+#define CPA_WRITER_SLOTS 2            /* records in flight (double buffering) */
+#define CPA_MAX_ZONES 16              /* fluid zones per detection call */
+#define CPA_MAX_DETECT_PHASES 8       /* phases per detection call */
+#define CPA_MAX_THRESHOLDS 16         /* volume fraction limits per detection call */
+#define CPA_TRACK_SEARCH_RADIUS 2.0   /* distance matching, in volume equivalent cube edges */
+#define CPA_TRACK_MAX_VOL_RATIO 2.0   /* distance matching, max. volume change */
+
+#if _ASYNC_OUTPUT && _OUTPUT == CPA_OUTPUT_BINARY && !defined(_WIN32)
+#include <pthread.h>
+#define CPA_ASYNC_WRITER 1
+#else
+#define CPA_ASYNC_WRITER 0
+#endif
 /* ------------------------------------------------------------------------- */
 
 
@@ -81,10 +175,289 @@ int cfileexists(const char * filename){
 
 /* ------------------------------------------------------------------------- */
 
+void DebugMessage(char Msg[])
+{
+    #if _MYDEBUG
+    Message(Msg);
+    #endif
+}
+
+/* ------------------------------------------------------------------------- */
+
+double cpaWallTime()	/* Wall clock time in seconds */
+{
+    #if defined(_OPENMP)
+    return omp_get_wtime();
+    #elif defined(_WIN32)
+    return (double) clock() / CLOCKS_PER_SEC;
+    #else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + 1e-9 * (double) ts.tv_nsec;
+    #endif
+}
+
+
+struct CpaTimings   /* Wall clock seconds and counters of the last cpa_detection() call */
+{
+    double  counting;                       /* cells of the fluid zones */
+    double  adjacency;                      /* neighbor graph (only if not cached) */
+    double  labelling;                      /* seed scan and growing / union find */
+    double  reduction;                      /* cpa properties, see cpaReduceCpas() */
+    double  stitching;                      /* global cpas, see cpaGlobalCpas() */
+    double  output;
+    double  total;
+    int     no_cells;
+    int     no_labelled_cells;              /* cells above the volume fraction limit */
+    int     no_cpas;
+    int     no_global_cpas;                 /* node 0, see cpaGlobalCpas() */
+    long    no_nb_lookups;                  /* neighbor cells (faces) visited in labelling */
+    long    no_boundary_updates;            /* boundary / partition faces added to cpas */
+    size_t  arena_bytes;                    /* storage of all cpas */
+};
+
+struct CpaTimings cpa_timings;              /* read by the standalone benchmark */
+
+struct CpaConfig    /* Settings of the current cpa_detection() call, see cpaReadConfig() */
+{
+    int     phases[CPA_MAX_DETECT_PHASES];  /* phase indices */
+    int     no_phases;
+    real    min_vol_frac;                   /* limit of the current labelling */
+    real    min_vol_fracs[CPA_MAX_THRESHOLDS];  /* all limits (sorted ascending) */
+    int     no_min_vol_fracs;
+    int     connectivity;
+    int     fluid_ids[CPA_MAX_ZONES];       /* cell zone ids */
+    int     no_fluid_ids;
+    int     label_udm;                      /* see cpaWriteLabels(), -1: no labels */
+};
+
+struct CpaConfig cpa_config = {{_PHASE_IDX}, 1, _MIN_VOL_FRAC, {_MIN_VOL_FRAC}, 1, 
+                                _CONNECTIVITY, {_FLUID_}, 1, _LABEL_UDM};
+
+/* ------------------------------------------------------------------------- */
+
+/*
+Arena (pool) allocator for all per cpa storage of a single detection call.
+Memory is taken from large blocks with geometric growth and released in one
+go at the end of cpa_detection(), so no per cell realloc/free is necessary.
+*/
+
+struct CpaArenaBlock
+{
+    struct CpaArenaBlock *next;
+    size_t  size;                           /* usable bytes in block */
+    size_t  used;                           /* used bytes in block */
+};
+
+struct CpaArena
+{
+    struct CpaArenaBlock *head;             /* current (newest) block */
+    size_t  next_block_size;                /* size of next block to allocate */
+    void    *last;                          /* last allocation (may grow in place) */
+    size_t  last_size;
+};
+
+#define CPA_ARENA_ALIGN(x) (((x) + CPA_ARENA_ALIGNMENT - 1) \
+                                & ~((size_t) CPA_ARENA_ALIGNMENT - 1))
+
+void initCpaArena(struct CpaArena *a)
+{
+    (*a).head = NULL;
+    (*a).next_block_size = CPA_ARENA_BLOCK_SIZE;
+    (*a).last = NULL;
+    (*a).last_size = 0;
+}
+
+
+void *cpaArenaAlloc(struct CpaArena *a, size_t size)
+{
+    struct CpaArenaBlock *b = (*a).head;
+    size_t block_size;
+    void *ptr = NULL;
+
+    size = CPA_ARENA_ALIGN(size);
+
+    if(CPA_ALLOC_FAILS())
+    {
+        DebugMessage("Error (arena): Allocation failed!\n");
+        return NULL;
+    }
+
+    if(b == NULL || (*b).used + size > (*b).size)
+    {
+        block_size = (*a).next_block_size;
+
+        while(block_size < size)
+        {
+            block_size *= 2;
+        }
+
+        b = (struct CpaArenaBlock*) malloc(CPA_ARENA_ALIGN(sizeof(struct CpaArenaBlock)) 
+                                            + block_size);
+
+        if(b == NULL)
+        {
+            DebugMessage("Error (malloc): No free memory for cpa arena block "
+                            "available!\n");
+            return NULL;
+        }
+
+        (*b).next = (*a).head;
+        (*b).size = block_size;
+        (*b).used = 0;
+        (*a).head = b;
+        (*a).next_block_size = 2*block_size;  /* geometric growth */
+    }
+
+    ptr = (char*) b + CPA_ARENA_ALIGN(sizeof(struct CpaArenaBlock)) + (*b).used;
+    (*b).used += size;
+
+    (*a).last = ptr;
+    (*a).last_size = size;
+
+    return ptr;
+}
+
+
+void *cpaArenaGrow(struct CpaArena *a, void *ptr, size_t old_size, size_t new_size)
+{
+/*
+    Grow an arena allocation, in place if it is the last allocation of the 
+    current block and there is enough room left, otherwise by copying
+*/
+    struct CpaArenaBlock *b = (*a).head;
+    void *new_ptr = NULL;
+
+    if(ptr == NULL)
+    {
+        return cpaArenaAlloc(a, new_size);
+    }
+
+    if(ptr == (*a).last && b != NULL 
+        && (*b).used - (*a).last_size + CPA_ARENA_ALIGN(new_size) <= (*b).size)
+    {
+        (*b).used = (*b).used - (*a).last_size + CPA_ARENA_ALIGN(new_size);
+        (*a).last_size = CPA_ARENA_ALIGN(new_size);
+        return ptr;
+    }
+
+    new_ptr = cpaArenaAlloc(a, new_size);
+
+    if(new_ptr != NULL)
+    {
+        memcpy(new_ptr, ptr, old_size);
+    }
+
+    return new_ptr;
+}
+
+
+int cpaArenaReserve(struct CpaArena *a, void **arr, int *capacity, int needed, 
+                    size_t elsize)
+{
+/*
+    Make sure arr (allocated in arena a) can hold needed elements, the 
+    capacity is doubled on each growth
+*/
+    int state = STATE_OK;
+    int new_capacity;
+    void *new_arr;
+
+    if(needed > *capacity)
+    {
+        new_capacity = (*capacity > 0) ? *capacity : CPA_MIN_LIST_CAPACITY;
+
+        while(new_capacity < needed)
+        {
+            new_capacity *= 2;
+        }
+
+        new_arr = cpaArenaGrow(a, *arr, (*capacity)*elsize, new_capacity*elsize);
+
+        if(new_arr != NULL)
+        {
+            *arr = new_arr;
+            *capacity = new_capacity;
+        }
+        else
+        {
+            state = STATE_ERROR;
+        }
+    }
+
+    return state;
+}
+
+
+void cpaArenaAdopt(struct CpaArena *a, struct CpaArena *child)
+{
+/*
+    Move all blocks of child (e.g. a per thread arena) to arena a, they are 
+    released together with a. The current block of a stays the current one.
+*/
+    struct CpaArenaBlock *tail = (*child).head;
+
+    if(tail != NULL)
+    {
+        while((*tail).next != NULL)
+        {
+            tail = (*tail).next;
+        }
+
+        if((*a).head != NULL)
+        {
+            (*tail).next = (*(*a).head).next;
+            (*(*a).head).next = (*child).head;
+        }
+        else
+        {
+            (*a).head = (*child).head;
+            (*a).last = NULL;
+        }
+    }
+
+    initCpaArena(child);
+}
+
+
+size_t cpaArenaBytes(struct CpaArena *a)	/* Allocated bytes of all blocks */
+{
+    struct CpaArenaBlock *b = (*a).head;
+    size_t bytes = 0;
+
+    while(b != NULL)
+    {
+        bytes += (*b).size;
+        b = (*b).next;
+    }
+
+    return bytes;
+}
+
+
+void releaseCpaArena(struct CpaArena *a)	/* Free all arena blocks at once */
+{
+    struct CpaArenaBlock *b = (*a).head;
+    struct CpaArenaBlock *next;
+
+    while(b != NULL)
+    {
+        next = (*b).next;
+        free(b);
+        b = next;
+    }
+
+    initCpaArena(a);
+}
+
+/* ------------------------------------------------------------------------- */
+
 struct Cpa
 {
     cell_t *cell_list;
     int    no_cells;
+    int    cell_list_capacity;
     real   com[ND_ND];                      /* center of mass (mass weighted average) */
     real   sumed_com_cell_weights[ND_ND];   /* intermediate values for com determination*/
     real   alpha_max;
@@ -95,188 +468,295 @@ struct Cpa
     face_t  *parboundary_faces_list;
     int    *boundary_id;
     int     no_boundaries;
-    char    **parboundary_name_list;
-    int     len_parboundary_name_list;
+    int     boundary_id_capacity;
+    int     parboundary_faces_capacity;
+    int     *parboundary_ranks;             /* neighbor compute nodes (procBoundary names) */
+    int     no_parboundary_ranks;
+    int     parboundary_ranks_capacity;
+    int     *boundary_id_hash;              /* hash sets of the lists above, see */
+    int     boundary_id_hash_size;          /* cpaIntListInsertUnique() */
+    int     *parboundary_faces_hash;
+    int     parboundary_faces_hash_size;
+    int     *parboundary_ranks_hash;
+    int     parboundary_ranks_hash_size;
+    int     *par_cells;                     /* C_ID of cells next to exterior cells ... */
+    int     no_par_cells;
+    int     par_cells_capacity;
+    int     *par_ext_cells;                 /* ... and C_ID of these exterior cells */
+    int     no_par_ext_cells;
+    int     par_ext_cells_capacity;
+    int     global_id;                      /* id of the stitched cpa, see cpaGlobalCpas() */
+    int     no_fragments;                   /* partition fragments of a stitched cpa */
+    int     zone;                           /* index in cpa_config.fluid_ids */
 };
 
-int initCpa(struct Cpa *d, cell_t c)	/* Initialize struct for single Cpa */	
+void resetCpa(struct Cpa *d)	/* Empty cpa without cells */
 {
-    int state = STATE_OK;
     int i;
 
-    (*d).no_cells = 1;
+    (*d).no_cells = 0;
     (*d).mass = 0.0;
     (*d).vol  = 0.0;
     (*d).alpha_max = 0.0;
     (*d).alpha_mean  = 0.0;
     (*d).cell_list = NULL;
-    (*d).cell_list = (cell_t*) calloc((*d).no_cells, sizeof(cell_t));
-    (*d).cell_list[0] = c;
+    (*d).cell_list_capacity = 0;
 
     for(i = 0; i < ND_ND; ++i)	/* ND_ND equals the number of dimensions: 2D -> ND_ND=2; 3D -> ND_ND=3 */	
     {
         (*d).com[i] = 0;
         (*d).sumed_com_cell_weights[i] = 0;
     }
-    
-    if((*d).cell_list != NULL)
-    {}
-    else 
-    {
-        DebugMessage("Error (calloc): No free memory for D.cells "
-                        "available!\n");
-        state = STATE_ERROR;
-    }
 
     (*d).no_parboundary_faces = 0;
     (*d).parboundary_faces_list = NULL;
-    (*d).parboundary_name_list = NULL;
-    (*d).len_parboundary_name_list = 0;
+    (*d).parboundary_faces_capacity = 0;
+    (*d).parboundary_ranks = NULL;
+    (*d).no_parboundary_ranks = 0;
+    (*d).parboundary_ranks_capacity = 0;
 
     (*d).boundary_id  = NULL;
     (*d).no_boundaries = 0;
+    (*d).boundary_id_capacity = 0;
+
+    (*d).boundary_id_hash = NULL;
+    (*d).boundary_id_hash_size = 0;
+    (*d).parboundary_faces_hash = NULL;
+    (*d).parboundary_faces_hash_size = 0;
+    (*d).parboundary_ranks_hash = NULL;
+    (*d).parboundary_ranks_hash_size = 0;
+
+    (*d).par_cells = NULL;
+    (*d).no_par_cells = 0;
+    (*d).par_cells_capacity = 0;
+    (*d).par_ext_cells = NULL;
+    (*d).no_par_ext_cells = 0;
+    (*d).par_ext_cells_capacity = 0;
+
+    (*d).global_id = -1;
+    (*d).no_fragments = 1;
+    (*d).zone = 0;
+}
+
+int initCpa(struct Cpa *d, cell_t c, struct CpaArena *a)	/* Initialize struct for single Cpa */	
+{
+    int state = STATE_OK;
+
+    resetCpa(d);
+
+    state = cpaArenaReserve(a, (void**) &((*d).cell_list), &((*d).cell_list_capacity),
+                                CPA_MIN_LIST_CAPACITY, sizeof(cell_t));
+    
+    if(state == STATE_OK)
+    {
+        (*d).cell_list[0] = c;
+        (*d).no_cells = 1;
+    }
+    else 
+    {
+        DebugMessage("Error (arena): No free memory for D.cells "
+                        "available!\n");
+    }
 
     return state;
 }
 
-int cpaCellsAppend(struct Cpa *d, cell_t val)
+int cpaCellsAppend(struct Cpa *d, cell_t val, struct CpaArena *a)
 {
     int state = STATE_OK;
 
-    (*d).no_cells ++;
-    (*d).cell_list = (cell_t*) realloc((*d).cell_list, 
-                                            (*d).no_cells*sizeof(cell_t));
+    state = cpaArenaReserve(a, (void**) &((*d).cell_list), &((*d).cell_list_capacity),
+                                (*d).no_cells + 1, sizeof(cell_t));
 
-    if((*d).cell_list != NULL) 
+    if(state == STATE_OK) 
     {
-        (*d).cell_list[(*d).no_cells-1] = val; /* append to end of array */
+        (*d).cell_list[(*d).no_cells] = val; /* append to end of array */
+        (*d).no_cells ++;
     }
     else 
     {
-        DebugMessage("Error (calloc): No free memory for D.cells "
+        DebugMessage("Error (arena): No free memory for D.cells "
                     "available!\n");
-        state = STATE_ERROR;
     }	
 
     return state;
 }
 
 
-void updateCpaWeights(struct Cpa *d, real c_mass, real x_c[ND_ND])	/* Update center of mass */
+int cpaIntListAppend(int **list, int *len, int *capacity, int val, struct CpaArena *a)
 {
-    int i = 0;
-
-    for(i = 0; i<ND_ND; ++i)
+    if(cpaArenaReserve(a, (void**) list, capacity, *len + 1, sizeof(int)) != STATE_OK)
     {
-        (*d).sumed_com_cell_weights[i] += x_c[i] * c_mass;
+        DebugMessage("Error (arena): No free memory for cpa list available!\n");
+        return STATE_ERROR;
     }
+
+    (*list)[*len] = val;
+    (*len) ++;
+
+    return STATE_OK;
 }
 
-void updateCpaBoundaryFaceID_List(struct Cpa *d, Thread *tf)
+
+
+/*
+Boundary zone ids, partition faces and neighbor ranks of a cpa are unique
+lists in the arena (in insertion order until finalizeCpa() sorts them). Short
+lists are searched linearly; once a list holds CPA_SET_MIN_HASH values its
+values are also kept in an open addressing hash set (linear probing, rebuilt
+with twice the size at 50 % load, storage in the arena), so cpas wetting a
+wall or cut by a partition boundary with many faces stay linear in time.
+*/
+
+#define CPA_SET_EMPTY INT_MIN
+#define CPA_SET_SLOT(v, size) ((int) (((size_t) (unsigned int) (v) * (size_t) 2654435761u) \
+                                        & (size_t) ((size) - 1)))
+
+int cpaIntSetRebuild(int **hash, int *hash_size, int *list, int len, struct CpaArena *a)
 {
-    int i = 0;
-    int boundary_id_used = 0;
-    int boundary_face_id = THREAD_ID(tf);
+    int size = 64;
+    int i, slot;
+    int *h;
+
+    while(size < 4*(len + 1))
+    {
+        size *= 2;
+    }
 
+    h = (int*) cpaArenaAlloc(a, size * sizeof(int));
 
-    if((*d).no_boundaries == 0)
+    if(h == NULL)
     {
-        (*d).boundary_id =  (int*) calloc(1, sizeof(int));
-        (*d).boundary_id[0] = boundary_face_id;
-        (*d).no_boundaries ++;
+        DebugMessage("Error (arena): No free memory for cpa hash set available!\n");
+        return STATE_ERROR;
     }
-    else
+
+    for(i = 0; i < size; ++i)
+    {
+        h[i] = CPA_SET_EMPTY;
+    }
+
+    for(i = 0; i < len; ++i)
     {
-        for(i = 0; i<(*d).no_boundaries; i++)
+        slot = CPA_SET_SLOT(list[i], size);
+
+        while(h[slot] != CPA_SET_EMPTY)
         {
-            if(boundary_face_id == (*d).boundary_id[i])
-            {
-                boundary_id_used = 1;
-                break;
-            }
+            slot = (slot + 1) & (size - 1);
         }
 
-        if(!boundary_id_used)
-        {   
-            (*d).no_boundaries ++;
-            (*d).boundary_id =  (int*) realloc((*d).boundary_id, 
-                                    (*d).no_boundaries*sizeof(int));
-            (*d).boundary_id[(*d).no_boundaries-1] = boundary_face_id;
-        }
+        h[slot] = list[i];
     }
+
+    *hash = h;
+    *hash_size = size;
+
+    return STATE_OK;
 }
 
 
-void updateCpaParBoundaryFaceID_List(struct Cpa *d,face_t newfaceid)
+int cpaIntListInsertUnique(
+                            int **list,
+                            int *len,
+                            int *capacity,
+                            int **hash,
+                            int *hash_size,
+                            int val,
+                            struct CpaArena *a
+                            )
 {
-    int i = 0;
-    int par_boundary_faceid_used = 0;
-
+/*
+    Append val to the list if it is not in the list yet, returns 1 if val
+    was added, 0 if it was already in the list and -1 on memory error
+*/
+    int i;
+    int slot = -1;
 
-    if((*d).no_parboundary_faces == 0)
+    if(*len < CPA_SET_MIN_HASH)
     {
-        (*d).parboundary_faces_list =  (int*) calloc(1, sizeof(int));
-        (*d).parboundary_faces_list[0] = newfaceid;
-        (*d).no_parboundary_faces ++;
+        for(i = 0; i < *len; ++i)
+        {
+            if((*list)[i] == val)
+            {
+                return 0;
+            }
+        }
     }
     else
     {
-        for(i = 0; i<(*d).no_parboundary_faces; i++)
+        if(2*(*len + 1) > *hash_size 
+            && cpaIntSetRebuild(hash, hash_size, *list, *len, a) != STATE_OK)
+        {
+            return -1;
+        }
+
+        slot = CPA_SET_SLOT(val, *hash_size);
+
+        while((*hash)[slot] != CPA_SET_EMPTY)
         {
-            if(newfaceid == (*d).parboundary_faces_list[i])
+            if((*hash)[slot] == val)
             {
-                par_boundary_faceid_used = 1;
-                break;
+                return 0;
             }
+            slot = (slot + 1) & (*hash_size - 1);
         }
+    }
 
-        if(!par_boundary_faceid_used)
-        {   
-            (*d).no_parboundary_faces ++;
-            (*d).parboundary_faces_list =  (int*) realloc((*d).parboundary_faces_list, 
-                                    (*d).no_parboundary_faces*sizeof(int));
-            (*d).parboundary_faces_list[(*d).no_parboundary_faces-1] = newfaceid;
-        }
+    if(cpaIntListAppend(list, len, capacity, val, a) != STATE_OK)
+    {
+        return -1;
+    }
+
+    if(slot >= 0)
+    {
+        (*hash)[slot] = val;
     }
+
+    return 1;
 }
 
-void updateParBoundaryNameList(struct Cpa *d, char pbname[])
+
+void updateCpaBoundaryID_List(struct Cpa *d, int boundary_face_id, struct CpaArena *a)
 {
-    int i = 0;
-    int cur_len;
-    int par_boundary_name_used = 0;
+    cpaIntListInsertUnique(&((*d).boundary_id), &((*d).no_boundaries), 
+                            &((*d).boundary_id_capacity), &((*d).boundary_id_hash), 
+                            &((*d).boundary_id_hash_size), boundary_face_id, a);
+}
 
-    if((*d).len_parboundary_name_list == 0)
-    {
-        (*d).parboundary_name_list =  (char**) malloc(1 * sizeof(char*));
 
-        (*d).parboundary_name_list[0] = (char*) malloc(STRLENMAX * sizeof(char));
-        strcpy((*d).parboundary_name_list[0], pbname);
-        (*d).len_parboundary_name_list ++;
-    }
-    else
-    {
-        for(i = 0; i<(*d).len_parboundary_name_list; ++i)
-        {
-            if(strcmp(pbname, (*d).parboundary_name_list[i]) == 0)
-            {
-                par_boundary_name_used = 1;
-                break;
-            } 
-        }
+void updateCpaParBoundaryFaceID_List(struct Cpa *d, face_t newfaceid, struct CpaArena *a)
+{
+    cpaIntListInsertUnique((int**) &((*d).parboundary_faces_list), 
+                            &((*d).no_parboundary_faces), 
+                            &((*d).parboundary_faces_capacity), 
+                            &((*d).parboundary_faces_hash), 
+                            &((*d).parboundary_faces_hash_size), (int) newfaceid, a);
+}
 
-        if(!par_boundary_name_used)
-        {
-            cur_len = (*d).len_parboundary_name_list;
 
-            (*d).parboundary_name_list =  (char**) realloc((*d).parboundary_name_list, 
-                                    (cur_len+1)*sizeof(char*));
+void updateCpaParBoundaryRankList(struct Cpa *d, int rank, struct CpaArena *a)
+{
+    cpaIntListInsertUnique(&((*d).parboundary_ranks), &((*d).no_parboundary_ranks), 
+                            &((*d).parboundary_ranks_capacity), 
+                            &((*d).parboundary_ranks_hash), 
+                            &((*d).parboundary_ranks_hash_size), rank, a);
+}
+
+
+int uniqueSortedInts(int *arr, int len)     /* remove duplicates, returns new length */
+{
+    int i, n = 0;
 
-            (*d).parboundary_name_list[cur_len] = (char*) malloc(STRLENMAX * sizeof(char));
-            strcpy((*d).parboundary_name_list[cur_len], pbname);
-            (*d).len_parboundary_name_list ++; 
+    for(i = 0; i < len; ++i)
+    {
+        if(n == 0 || arr[i] != arr[n-1])
+        {
+            arr[n] = arr[i];
+            n ++;
         }
     }
+
+    return n;
 }
 
 
@@ -291,25 +771,172 @@ void setFinalCpaCOM(struct Cpa *d)
 }
 
 
-int printCpaCells(char filesuffix[], struct Cpa *DList, int sizeDList, Thread *ct)
+int compareInt(const void *a, const void *b)
 {
-    FILE *fd = NULL;
-    int state = STATE_OK;
-    int i,j;
-    char filename[100];
+    int ia = *((const int*) a);
+    int ib = *((const int*) b);
 
-    sprintf(filename, "%i_cells_%s", myid, filesuffix);
+    return (ia > ib) - (ia < ib);
+}
 
-    fd = fopen(filename, "a");
 
-    if(fd == NULL)
+int compareIntPair(const void *a, const void *b)	/* lexicographic, int[2] */
+{
+    const int *ia = (const int*) a;
+    const int *ib = (const int*) b;
+
+    if(ia[0] != ib[0])
     {
-        Message("Error (printCpas()): Unable to open file %s "
-                "for writing!\n", filename);
-        state = STATE_ERROR;
+        return (ia[0] > ib[0]) - (ia[0] < ib[0]);
     }
-    else
-    {
+
+    return (ia[1] > ib[1]) - (ia[1] < ib[1]);
+}
+
+
+void mergeCpa(struct Cpa *d, struct Cpa *part, struct CpaArena *a)
+{
+/*
+    Add the (not finalized) sums and lists of partial cpa part to cpa d
+*/
+    int i;
+
+    (*d).mass += (*part).mass;
+    (*d).vol += (*part).vol;
+    (*d).alpha_mean += (*part).alpha_mean;
+
+    if((*d).alpha_max < (*part).alpha_max)
+    {
+        (*d).alpha_max = (*part).alpha_max;
+    }
+
+    for(i = 0; i<ND_ND; ++i)
+    {
+        (*d).sumed_com_cell_weights[i] += (*part).sumed_com_cell_weights[i];
+    }
+
+    for(i = 0; i<(*part).no_boundaries; ++i)
+    {
+        updateCpaBoundaryID_List(d, (*part).boundary_id[i], a);
+    }
+
+    for(i = 0; i<(*part).no_parboundary_faces; ++i)
+    {
+        updateCpaParBoundaryFaceID_List(d, (*part).parboundary_faces_list[i], a);
+    }
+
+    for(i = 0; i<(*part).no_parboundary_ranks; ++i)
+    {
+        updateCpaParBoundaryRankList(d, (*part).parboundary_ranks[i], a);
+    }
+
+    for(i = 0; i<(*part).no_par_cells; ++i)
+    {
+        cpaIntListAppend(&((*d).par_cells), &((*d).no_par_cells), 
+                            &((*d).par_cells_capacity), (*part).par_cells[i], a);
+    }
+
+    for(i = 0; i<(*part).no_par_ext_cells; ++i)
+    {
+        cpaIntListAppend(&((*d).par_ext_cells), &((*d).no_par_ext_cells), 
+                            &((*d).par_ext_cells_capacity), (*part).par_ext_cells[i], a);
+    }
+}
+
+
+void finalizeCpa(struct Cpa *d)
+{
+/*
+    Final averages, boundary lists are sorted so the output does not depend 
+    on the order in which the cells were visited
+*/
+    (*d).alpha_mean = (*d).alpha_mean/(*d).no_cells;
+
+    setFinalCpaCOM(d);
+
+    if((*d).no_boundaries > 1)
+    {
+        qsort((*d).boundary_id, (*d).no_boundaries, sizeof(int), compareInt);
+    }
+
+    if((*d).no_parboundary_faces > 1)
+    {
+        qsort((*d).parboundary_faces_list, (*d).no_parboundary_faces, sizeof(face_t), 
+                compareInt);
+    }
+
+    if((*d).no_parboundary_ranks > 1)
+    {
+        qsort((*d).parboundary_ranks, (*d).no_parboundary_ranks, sizeof(int), compareInt);
+    }
+
+    if((*d).no_par_cells > 1)
+    {
+        qsort((*d).par_cells, (*d).no_par_cells, sizeof(int), compareInt);
+    }
+
+    if((*d).no_par_ext_cells > 1)
+    {
+        qsort((*d).par_ext_cells, (*d).no_par_ext_cells, sizeof(int), compareInt);
+        (*d).no_par_ext_cells = uniqueSortedInts((*d).par_ext_cells, (*d).no_par_ext_cells);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+struct CpaList      /* Growable list of detected cpas (storage in arena) */
+{
+    struct Cpa *cpas;
+    int     no_cpas;
+    int     capacity;
+};
+
+void initCpaList(struct CpaList *l)
+{
+    (*l).cpas = NULL;
+    (*l).no_cpas = 0;
+    (*l).capacity = 0;
+}
+
+
+struct Cpa *cpaListNew(struct CpaList *l, struct CpaArena *a)
+{
+/*
+    Append a new (uninitialized) cpa to the list and return it, so the cpa 
+    can be built in place. The pointer is valid until the next call.
+*/
+    if(cpaArenaReserve(a, (void**) &((*l).cpas), &((*l).capacity),
+                        (*l).no_cpas + 1, sizeof(struct Cpa)) != STATE_OK)
+    {
+        DebugMessage("Error (arena): No free memory for DList available!\n");
+        return NULL;
+    }
+
+    (*l).no_cpas ++;
+
+    return &((*l).cpas[(*l).no_cpas - 1]);
+}
+
+
+int printCpaCells(char filesuffix[], struct Cpa *DList, int sizeDList, Thread *ct)
+{
+    FILE *fd = NULL;
+    int state = STATE_OK;
+    int i,j;
+    char filename[100];
+
+    sprintf(filename, "%i_cells_%s", myid, filesuffix);
+
+    fd = fopen(filename, "a");
+
+    if(fd == NULL)
+    {
+        Message("Error (printCpas()): Unable to open file %s "
+                "for writing!\n", filename);
+        state = STATE_ERROR;
+    }
+    else
+    {
         fprintf(fd, "{\n");
         fprintf(fd, "%lf\n", CURRENT_TIME);
         fprintf(fd,"cell_count[cells]\n");
@@ -370,23 +997,23 @@ int printCpas(char filesuffix[], struct Cpa *DList, int sizeDList)
             fprintf(fd, "%lE,", DList[i].alpha_max);
 
             fprintf(fd, "[");
-            if(DList[i].no_boundaries > 0 || DList[i].len_parboundary_name_list >0)
+            if(DList[i].no_boundaries > 0 || DList[i].no_parboundary_ranks >0)
             {
                 for(j = 0; j < DList[i].no_boundaries; ++j)
                 {
                     fprintf(fd, "%i", DList[i].boundary_id[j]);
 
-                    if(j < (DList[i].no_boundaries -1) || DList[i].len_parboundary_name_list>0)
+                    if(j < (DList[i].no_boundaries -1) || DList[i].no_parboundary_ranks>0)
                     {
                         fprintf(fd, ",");
                     }
                 }
 
-                for(j = 0; j < DList[i].len_parboundary_name_list; j++)
+                for(j = 0; j < DList[i].no_parboundary_ranks; j++)
                 {
-                    fprintf(fd, "%s", DList[i].parboundary_name_list[j]);
+                    fprintf(fd, "procBoundary%ito%i", myid, DList[i].parboundary_ranks[j]);
 
-                    if(j < (DList[i].len_parboundary_name_list-1))
+                    if(j < (DList[i].no_parboundary_ranks-1))
                     {
                         fprintf(fd, ",");
                     }
@@ -424,368 +1051,4853 @@ int printCpas(char filesuffix[], struct Cpa *DList, int sizeDList)
     return state;
 }
 
-/* ------------------------------------------------------------------------- */
 
-void DebugMessage(char Msg[])
+int printGlobalCpas(char filename[], struct Cpa *GList, int sizeGList)
 {
-    #if _MYDEBUG
-    Message(Msg);
-    #endif
+    FILE *fd = NULL;
+    int state = STATE_OK;
+    int i,j;
+
+    fd = fopen(filename, "a");
+
+    if(fd == NULL)
+    {
+        Message("Error (printGlobalCpas()): Unable to open file %s "
+                "for writing!\n", filename);
+        state = STATE_ERROR;
+    }
+    else
+    {
+        fprintf(fd, "{\n");
+        fprintf(fd, "%lf\n", CURRENT_TIME);
+        fprintf(fd,"global_id,cell_count[com.(x)_in_m,com.(y),com.(z),mass_in_kg,"
+                    "volume_in_m³,cellAveragedAlpha,maxAlpha,"
+                    "[list_of_boundary_names],no_of_partition_fragments]\n");
+
+        for(i = 0; i < sizeGList; ++i)
+        {
+            fprintf(fd, "%i,%i[", GList[i].global_id, GList[i].no_cells);
+            for(j = 0; j <ND_ND; ++j)
+            {
+                fprintf(fd, " %lf,", GList[i].com[j]);
+            }
+            fprintf(fd, "%lE,", GList[i].mass);
+            fprintf(fd, "%lE,", GList[i].vol);
+            fprintf(fd, "%lE,", GList[i].alpha_mean);
+            fprintf(fd, "%lE,", GList[i].alpha_max);
+
+            fprintf(fd, "[");
+            for(j = 0; j < GList[i].no_boundaries; ++j)
+            {
+                fprintf(fd, "%i", GList[i].boundary_id[j]);
+
+                if(j < (GList[i].no_boundaries -1))
+                {
+                    fprintf(fd, ",");
+                }
+            }
+            fprintf(fd, "],%i]\n", GList[i].no_fragments);
+        }
+        fprintf(fd, "}\n");
+    }
+
+    if(fd != NULL)
+    {
+        fclose(fd);
+    }
+    return state;
 }
 
-/* ------------------------------------------------------------------------- */
 
-int setCellAsChecked(int *cell_checked_arr, int cell_count, int i)
+int cpaWriteFile(char filename[], char *buf, size_t bytes)	/* append, no Message() */
 {
+    FILE *fd = NULL;
     int state = STATE_OK;
 
-    if(i >= 0 && i < cell_count)
+    fd = fopen(filename, "ab");
+
+    if(fd == NULL)
     {
-        cell_checked_arr[i] = CELL_CHECKED;
+        state = STATE_ERROR;
     }
     else
     {
-        Message("Warning setCellAsChecked(): Index %i for checked cells range from 0 to %i out of bounds\n", i, cell_count);
-        state = STATE_ERROR;
+        if(fwrite(buf, 1, bytes, fd) != bytes)
+        {
+            state = STATE_ERROR;
+        }
+
+        if(fclose(fd) != 0)
+        {
+            state = STATE_ERROR;
+        }
     }
 
     return state;
 }
 
-/* ------------------------------------------------------------------------- */
+#if CPA_ASYNC_WRITER
+/*
+Background writer: cpa_detection() hands the serialized records to a writer 
+thread and continues. At most CPA_WRITER_SLOTS records are in flight (one 
+written, one waiting), if both slots are taken the solver waits for the 
+writer (back pressure). The writer thread must not call Fluent functions, 
+write errors are reported by the solver thread on the next submit or flush.
+*/
 
-int copyCell_tArray(cell_t **toarr, cell_t *fromarr, int arrsize)
+struct CpaWriterJob
 {
-    int i;
-    int state = STATE_OK;
+    char    filename[100];
+    char    *buf;
+    size_t  bytes;
+};
 
-    *toarr = (cell_t *) calloc(arrsize, sizeof(cell_t));
+static pthread_mutex_t cpa_writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cpa_writer_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t cpa_writer_thread;
+static int cpa_writer_running = 0;
+static int cpa_writer_stop = 0;
+static struct CpaWriterJob cpa_writer_jobs[CPA_WRITER_SLOTS];
+static int cpa_writer_head = 0;                 /* oldest job */
+static int cpa_writer_count = 0;                /* jobs in flight */
+static int cpa_writer_failed = 0;
+static char cpa_writer_failed_file[100];
 
-    if(*toarr != NULL) 
+
+void *cpaWriterMain(void *arg)
+{
+    struct CpaWriterJob job;
+    int state;
+
+    pthread_mutex_lock(&cpa_writer_lock);
+
+    for(;;)
     {
-        for(i = 0; i < arrsize; ++i)
+        while(cpa_writer_count == 0 && !cpa_writer_stop)
         {
-            (*toarr)[i] = fromarr[i];
+            pthread_cond_wait(&cpa_writer_cond, &cpa_writer_lock);
         }
-    }else 
-    {
-        DebugMessage("\nError: Kein freier Speicher für Copy Calloc vorhanden.\n");
-        state = STATE_ERROR;
+
+        if(cpa_writer_count == 0)
+        {
+            break;
+        }
+
+        job = cpa_writer_jobs[cpa_writer_head];
+        pthread_mutex_unlock(&cpa_writer_lock);
+
+        state = cpaWriteFile(job.filename, job.buf, job.bytes);
+        free(job.buf);
+
+        pthread_mutex_lock(&cpa_writer_lock);
+
+        if(state != STATE_OK)
+        {
+            cpa_writer_failed ++;
+            strcpy(cpa_writer_failed_file, job.filename);
+        }
+
+        /* slot is free after the record is on disk */
+        cpa_writer_head = (cpa_writer_head + 1) % CPA_WRITER_SLOTS;
+        cpa_writer_count --;
+        pthread_cond_broadcast(&cpa_writer_cond);
     }
 
-    return state;
+    pthread_mutex_unlock(&cpa_writer_lock);
+
+    return arg;
 }
 
 
-int copyRealND_ND_Array(real (*toarr)[ND_ND], real *fromarr, int arrsize)
+int cpaWriterReportErrors()	/* call with cpa_writer_lock held */
 {
-    int i;
-    int state = STATE_OK;
-
-    for(i = 0; i < arrsize; ++i)
+    if(cpa_writer_failed > 0)
     {
-        (*toarr)[i] = fromarr[i];
+        Message("Error (cpaWriter): %i record(s) could not be written, last file %s!\n",
+                cpa_writer_failed, cpa_writer_failed_file);
+        cpa_writer_failed = 0;
+        return STATE_ERROR;
     }
 
-    return state;
+    return STATE_OK;
 }
 
 
-int copyIntArray(int **toarr, int *fromarr, int arrsize)
+int cpaWriterSubmit(char filename[], char *buf, size_t bytes)
 {
-    int i;
+/*
+    Queue buf (malloc'ed, owned by the writer afterwards) for appending to 
+    filename, blocks while all slots are in use
+*/
     int state = STATE_OK;
+    struct CpaWriterJob *job = NULL;
 
-    *toarr = (int *) calloc(arrsize, sizeof(int));
+    pthread_mutex_lock(&cpa_writer_lock);
 
-    if(*toarr != NULL) 
+    if(!cpa_writer_running)
     {
-        for(i = 0; i < arrsize; ++i)
+        cpa_writer_stop = 0;
+
+        if(pthread_create(&cpa_writer_thread, NULL, cpaWriterMain, NULL) == 0)
         {
-            (*toarr)[i] = fromarr[i];
+            cpa_writer_running = 1;
         }
-    }else 
+    }
+
+    if(!cpa_writer_running)
     {
-        DebugMessage("\nError: Kein freier Speicher für Copy Calloc vorhanden.\n");
-        state = STATE_ERROR;
+        /* no thread available, write synchronously */
+        pthread_mutex_unlock(&cpa_writer_lock);
+        state = cpaWriteFile(filename, buf, bytes);
+        free(buf);
+
+        if(state != STATE_OK)
+        {
+            Message("Error (cpaWriterSubmit()): Unable to write to file %s!\n", filename);
+        }
+
+        return state;
+    }
+
+    while(cpa_writer_count == CPA_WRITER_SLOTS)
+    {
+        pthread_cond_wait(&cpa_writer_cond, &cpa_writer_lock);
     }
 
+    job = &(cpa_writer_jobs[(cpa_writer_head + cpa_writer_count) % CPA_WRITER_SLOTS]);
+    strncpy((*job).filename, filename, sizeof((*job).filename) - 1);
+    (*job).filename[sizeof((*job).filename) - 1] = '\0';
+    (*job).buf = buf;
+    (*job).bytes = bytes;
+    cpa_writer_count ++;
+
+    pthread_cond_broadcast(&cpa_writer_cond);
+    state = cpaWriterReportErrors();
+    pthread_mutex_unlock(&cpa_writer_lock);
+
     return state;
 }
+#endif
 
 
-int copyCharArrays(char ***toarr, char **fromarr, int arrsize, int chararrsize)
+int cpaWriterFlush()	/* Wait until all queued records are written */
 {
-    int i;
     int state = STATE_OK;
 
-    *toarr = (char **) malloc(arrsize * sizeof(char*));
+    #if CPA_ASYNC_WRITER
+    pthread_mutex_lock(&cpa_writer_lock);
 
-    if(*toarr != NULL) 
+    while(cpa_writer_count > 0)
     {
-        for(i = 0; i < arrsize; ++i)
-        {
-            (*toarr)[i] = (char*) malloc(chararrsize * sizeof(char));
-            strcpy((*toarr)[i], fromarr[i]);
-        }
-    }else 
-    {
-        DebugMessage("\nError: Kein freier Speicher für Copy Calloc vorhanden.\n");
-        state = STATE_ERROR;
+        pthread_cond_wait(&cpa_writer_cond, &cpa_writer_lock);
     }
 
+    state = cpaWriterReportErrors();
+    pthread_mutex_unlock(&cpa_writer_lock);
+    #endif
+
     return state;
 }
 
-/* ------------------------------------------------------------------------- */
 
-void resetIntArray(int *arr, int size, int val)
+void cpaWriterStop()	/* Flush and end the writer thread (end of run) */
 {
-    int i = 0;
+    #if CPA_ASYNC_WRITER
+    int running;
 
-    for(i=0; i<size; ++i)
+    cpaWriterFlush();
+
+    pthread_mutex_lock(&cpa_writer_lock);
+    running = cpa_writer_running;
+    cpa_writer_stop = 1;
+    pthread_cond_broadcast(&cpa_writer_cond);
+    pthread_mutex_unlock(&cpa_writer_lock);
+
+    if(running)
     {
-        arr[i] = val;
+        pthread_join(cpa_writer_thread, NULL);
+        cpa_writer_running = 0;
     }
+    #endif
 }
 
 
-void getCellsFaceNeighborCells(
-                                cell_t c0, 
-                                Thread *c0t,
-                                cell_t nocells_c0t, 
-                                cell_t *cfncarr, 
-                                int *cfncarr_size
-                                )
+/*
+Binary output: one record per detection call is appended to the file with a
+single fwrite. All values in native byte order (int: 32 bit, real: double).
+
+    header (CPA_BIN_HEADER_BYTES):
+        0   char[4] "CPAD"
+        4   int     CPA_BIN_VERSION
+        8   int     record size in bytes (including header)
+        12  int     ND_ND
+        16  double  flow time
+        24  int     rank (myid, -1 for global cpas)
+        28  int     n   number of cpas
+        32  int     nb  number of boundary ids (all cpas)
+        36  int     nf  number of partition boundary faces
+        40  int     nr  number of neighbor ranks
+        44  int     reserved (0)
+    columns:
+        double  com[ND_ND][n], mass[n], vol[n], alpha_mean[n], alpha_max[n]
+        int     no_cells[n], global_id[n], no_fragments[n]
+        int     boundary_offset[n+1], face_offset[n+1], rank_offset[n+1]
+        int     boundary_ids[nb], faces[nf], ranks[nr]
+
+The lists of cpa i are list[offset[i]] ... list[offset[i+1]-1].
+*/
+
+int writeCpasBinary(char filename[], int rank, struct Cpa *DList, int sizeDList)
 {
-    int n;
-    int i=0;
-    face_t f;
-    Thread *tf;
-    cell_t c0x, c1x;
-    *cfncarr_size = 0;
+    int state = STATE_OK;
+    int i, j;
+    int n = sizeDList;
+    int nb = 0, nf = 0, nr = 0;
+    int header[CPA_BIN_HEADER_BYTES/sizeof(int)];
+    double time = CURRENT_TIME;
+    size_t record_bytes;
+    char *buf = NULL;
+    double *pr = NULL;
+    int *pi = NULL;
+
+    for(i = 0; i < n; ++i)
+    {
+        nb += DList[i].no_boundaries;
+        nf += DList[i].no_parboundary_faces;
+        nr += DList[i].no_parboundary_ranks;
+    }
 
-    c_face_loop(c0, c0t, n)
+    record_bytes = CPA_BIN_HEADER_BYTES + (size_t) (ND_ND + 4) * n * sizeof(double)
+                    + ((size_t) 6 * n + 3 + nb + nf + nr) * sizeof(int);
+
+    buf = (char*) malloc(record_bytes);
+
+    if(buf == NULL)
     {
-        f = C_FACE(c0,c0t,n);            /*return thread global face index*/
-        tf = C_FACE_THREAD(c0,c0t,n);
+        DebugMessage("Error (malloc): No free memory for binary output available!\n");
+        return STATE_ERROR;
+    }
 
-        if(tf != NULL && !BOUNDARY_FACE_THREAD_P(tf))
+    memset(header, 0, sizeof(header));
+    memcpy(header, "CPAD", 4);
+    header[1] = CPA_BIN_VERSION;
+    header[2] = (int) record_bytes;
+    header[3] = ND_ND;
+    header[6] = rank;
+    header[7] = n;
+    header[8] = nb;
+    header[9] = nf;
+    header[10] = nr;
+    memcpy(buf, header, CPA_BIN_HEADER_BYTES);
+    memcpy(buf + 16, &time, sizeof(double));
+
+    pr = (double*) (buf + CPA_BIN_HEADER_BYTES);
+    pi = (int*) (pr + (ND_ND + 4) * n);
+
+    for(i = 0; i < n; ++i)
+    {
+        for(j = 0; j < ND_ND; ++j)
         {
-            c0x = F_C0(f, tf);
-            c1x = F_C1(f, tf);
-            
-            if(i < NO_MAX_CELL_FACE_NEIGHBOR_CELLS)
-            {
-                if (c0x == c0)
-                {   
-                    if(c1x > 0 && c1x < nocells_c0t)
-                    {
-                        cfncarr[i] = c1x;
-                        i += 1;
-                    }
-                }
-                else if(c1x == c0)
-                {
-                    if(c0x > 0 && c0x < nocells_c0t)
-                    {
-                        cfncarr[i] = c0x;
-                        i += 1;
-                    }
-                }	
+            pr[j*n + i] = DList[i].com[j];
+        }
+
+        pr[ND_ND*n + i] = DList[i].mass;
+        pr[(ND_ND+1)*n + i] = DList[i].vol;
+        pr[(ND_ND+2)*n + i] = DList[i].alpha_mean;
+        pr[(ND_ND+3)*n + i] = DList[i].alpha_max;
+
+        pi[i] = DList[i].no_cells;
+        pi[n + i] = DList[i].global_id;
+        pi[2*n + i] = DList[i].no_fragments;
+    }
+
+    /* offsets, then lists */
+    pi += 3*n;
+    pi[0] = 0;
+    pi[n+1] = 0;
+    pi[2*n+2] = 0;
+
+    for(i = 0; i < n; ++i)
+    {
+        pi[i+1] = pi[i] + DList[i].no_boundaries;
+        pi[n+1 + i+1] = pi[n+1 + i] + DList[i].no_parboundary_faces;
+        pi[2*n+2 + i+1] = pi[2*n+2 + i] + DList[i].no_parboundary_ranks;
+    }
+
+    pi += 3*n + 3;
+
+    for(i = 0; i < n; ++i)
+    {
+        for(j = 0; j < DList[i].no_boundaries; ++j)
+        {
+            *(pi++) = DList[i].boundary_id[j];
+        }
+    }
+
+    for(i = 0; i < n; ++i)
+    {
+        for(j = 0; j < DList[i].no_parboundary_faces; ++j) 
+        {
+            *(pi++) = (int) DList[i].parboundary_faces_list[j];
+        }
+    }
+
+    for(i = 0; i < n; ++i)
+    {
+        for(j = 0; j < DList[i].no_parboundary_ranks; ++j)
+        {
+            *(pi++) = DList[i].parboundary_ranks[j];
+        }
+    }
+
+    #if CPA_ASYNC_WRITER
+    state = cpaWriterSubmit(filename, buf, record_bytes);  /* takes buf */
+    #else
+    state = cpaWriteFile(filename, buf, record_bytes);
+
+    if(state != STATE_OK)
+    {
+        Message("Error (writeCpasBinary()): Unable to write to file %s!\n", filename);
+    }
+
+    free(buf);
+    #endif
+
+    return state;
+}
+
+
+/* ------------------------------------------------------------------------- */
+
+/*
+Packed cell bitsets (one bit per cell): the interior cells above the volume 
+fraction limit are collected once per labelling in a branch free sweep over 
+the VOF array, so the labelling engines test a bit instead of reading C_VOF 
+through the phase thread again for every neighbor. The visited state of the 
+flood fill is a bitset of the same size. Both are kept between calls and only
+reallocated if the cell count grows.
+*/
+
+typedef unsigned long cpa_bits_t;
+
+#define CPA_WORD_BITS ((int) (8 * sizeof(cpa_bits_t)))
+#define CPA_BIT_WORDS(n) (((n) + CPA_WORD_BITS - 1) / CPA_WORD_BITS)
+#define CPA_BIT_TEST(b, i) (((b)[(i) / CPA_WORD_BITS] >> ((i) % CPA_WORD_BITS)) & 1)
+#define CPA_BIT_SET(b, i) ((b)[(i) / CPA_WORD_BITS] |= (cpa_bits_t) 1 << ((i) % CPA_WORD_BITS))
+
+static cpa_bits_t *cpa_above_bits = NULL;   /* interior cells above the limit */
+static cpa_bits_t *cpa_visited_bits = NULL; /* flood fill */
+static int cpa_bits_capacity = 0;           /* words of both bitsets */
+
+
+int cpaCellBits(
+                Thread *ct,
+                Thread *ptp,
+                real min_vol_frac,
+                int use_threads,
+                cpa_bits_t **above,
+                cpa_bits_t **visited
+                )
+{
+/*
+    Bitset of the interior cells of ct with a volume fraction above 
+    min_vol_frac (exterior cells are never set, they belong to other compute 
+    nodes) and a cleared visited bitset, both cover all cells of ct
+*/
+    int w, i, lo, hi;
+    int no_int_cells = THREAD_N_ELEMENTS_INT(ct);
+    int no_words = CPA_BIT_WORDS(no_int_cells + THREAD_N_ELEMENTS_EXT(ct)) + 1;
+    cpa_bits_t bits;
+
+    if(no_words > cpa_bits_capacity)
+    {
+        if(cpa_above_bits != NULL) free(cpa_above_bits);
+        if(cpa_visited_bits != NULL) free(cpa_visited_bits);
+
+        cpa_above_bits = (cpa_bits_t*) malloc(no_words * sizeof(cpa_bits_t));
+        cpa_visited_bits = (cpa_bits_t*) malloc(no_words * sizeof(cpa_bits_t));
+        cpa_bits_capacity = no_words;
+
+        if(cpa_above_bits == NULL || cpa_visited_bits == NULL)
+        {
+            DebugMessage("Error (malloc): No free memory for cell bitsets available!\n");
+            if(cpa_above_bits != NULL) free(cpa_above_bits);
+            if(cpa_visited_bits != NULL) free(cpa_visited_bits);
+            cpa_above_bits = NULL;
+            cpa_visited_bits = NULL;
+            cpa_bits_capacity = 0;
+            return STATE_ERROR;
+        }
+    }
+
+    #ifndef _OPENMP
+    (void) use_threads;                     /* single-threaded build */
+    #endif
+
+    #pragma omp parallel for private(i, lo, hi, bits) if(use_threads)
+    for(w = 0; w < no_words; ++w)
+    {
+        lo = w * CPA_WORD_BITS;
+        hi = (lo + CPA_WORD_BITS < no_int_cells) ? lo + CPA_WORD_BITS : no_int_cells;
+        bits = 0;
+
+        for(i = lo; i < hi; ++i)
+        {
+            bits |= (cpa_bits_t) (C_VOF(i, ptp) > min_vol_frac) << (i - lo);
+        }
+
+        cpa_above_bits[w] = bits;
+        cpa_visited_bits[w] = 0;
+    }
+
+    *above = cpa_above_bits;
+    *visited = cpa_visited_bits;
+
+    return STATE_OK;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void resetIntArray(int *arr, int size, int val)
+{
+    int i = 0;
+
+    for(i=0; i<size; ++i)
+    {
+        arr[i] = val;
+    }
+}
+
+
+void getCellsFaceNeighborCells(
+                                cell_t c0, 
+                                Thread *c0t,
+                                cell_t nocells_c0t, 
+                                cell_t *cfncarr, 
+                                face_t *cfnfarr,
+                                int *cfncarr_size,
+                                int *cbidarr,
+                                int *cbidarr_size
+                                )
+{
+/*
+    Face neighbor cells of c0 with the global id of the connecting face 
+    (cfnfarr) and the zone ids of the boundary faces of c0 (cbidarr), 
+    collected in one loop over the faces of c0. cfnfarr and cbidarr may be 
+    NULL.
+*/
+    int n;
+    int i=0, j=0;
+    face_t f;
+    Thread *tf;
+    cell_t c0x, c1x, cx;
+    *cfncarr_size = 0;
+
+    c_face_loop(c0, c0t, n)
+    {
+        f = C_FACE(c0,c0t,n);            /*return thread global face index*/
+        tf = C_FACE_THREAD(c0,c0t,n);
+
+        if(tf != NULL && BOUNDARY_FACE_THREAD_P(tf))
+        {
+            if(cbidarr != NULL && j < NO_MAX_CELL_FACE_NEIGHBOR_CELLS)
+            {
+                cbidarr[j] = THREAD_ID(tf);
+                j += 1;
+            }
+        }
+        else if(tf != NULL)
+        {
+            c0x = F_C0(f, tf);
+            c1x = F_C1(f, tf);
+            cx = -1;
+            
+            if(i < NO_MAX_CELL_FACE_NEIGHBOR_CELLS)
+            {
+                if (c0x == c0)
+                {   
+                    if(c1x >= 0 && c1x < nocells_c0t)
+                    {
+                        cx = c1x;
+                    }
+                }
+                else if(c1x == c0)
+                {
+                    if(c0x >= 0 && c0x < nocells_c0t)
+                    {
+                        cx = c0x;
+                    }
+                }	
+
+                if(cx >= 0)
+                {
+                    cfncarr[i] = cx;
+
+                    if(cfnfarr != NULL)
+                    {
+                        cfnfarr[i] = F_ID(f, tf);
+                    }
+                    i += 1;
+                }
+            }
+            else
+            {
+                Message("Error getCellsFaceNeighborCells(): Face index going to high!\n");
+            } 
+        }
+    }
+
+    *cfncarr_size = i;
+
+    if(cbidarr_size != NULL)
+    {
+        *cbidarr_size = j;
+    }
+}
+
+
+int occursInCellArray(cell_t *arr, int arr_size, cell_t val)
+{
+    int i;
+
+    for(i=0; i<arr_size; ++i)
+    {
+        if(arr[i] == val)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------------*/
+
+/*
+Open addressing hash map (linear probing) from size_t keys (e.g. node 
+pointers) to int values, grows at 50 % load.
+*/
+
+struct CpaHashMap
+{
+    size_t  *keys;
+    int     *vals;
+    int     size;                       /* number of slots (power of 2) */
+    int     used;
+};
+
+#define CPA_HASH_EMPTY (~((size_t) 0))
+#define CPA_HASH_SLOT(k, size) ((int) ((((k) ^ ((k) >> 17)) * (size_t) 2654435761u) \
+                                        & (size_t) ((size) - 1)))
+
+int initCpaHashMap(struct CpaHashMap *m, int expected)
+{
+    int i;
+
+    (*m).size = 64;
+    (*m).used = 0;
+
+    while((*m).size < 2*expected)
+    {
+        (*m).size *= 2;
+    }
+
+    (*m).keys = (size_t*) malloc((*m).size * sizeof(size_t));
+    (*m).vals = (int*) malloc((*m).size * sizeof(int));
+
+    if((*m).keys == NULL || (*m).vals == NULL)
+    {
+        DebugMessage("Error (malloc): No free memory for hash map available!\n");
+        return STATE_ERROR;
+    }
+
+    for(i = 0; i < (*m).size; ++i)
+    {
+        (*m).keys[i] = CPA_HASH_EMPTY;
+    }
+
+    return STATE_OK;
+}
+
+
+void freeCpaHashMap(struct CpaHashMap *m)
+{
+    if((*m).keys != NULL) free((*m).keys);
+    if((*m).vals != NULL) free((*m).vals);
+
+    (*m).keys = NULL;
+    (*m).vals = NULL;
+    (*m).size = 0;
+    (*m).used = 0;
+}
+
+
+int cpaHashMapInsert(struct CpaHashMap *m, size_t key, int val)
+{
+/*
+    Insert key with val if key is not in map yet, return the value stored 
+    for key (or -1 on memory error)
+*/
+    struct CpaHashMap grown;
+    int slot, i;
+
+    if(2*((*m).used + 1) > (*m).size)
+    {
+        if(initCpaHashMap(&grown, (*m).size) != STATE_OK)
+        {
+            freeCpaHashMap(&grown);
+            return -1;
+        }
+
+        for(i = 0; i < (*m).size; ++i)
+        {
+            if((*m).keys[i] != CPA_HASH_EMPTY)
+            {
+                cpaHashMapInsert(&grown, (*m).keys[i], (*m).vals[i]);
+            }
+        }
+
+        freeCpaHashMap(m);
+        *m = grown;
+    }
+
+    slot = CPA_HASH_SLOT(key, (*m).size);
+
+    while((*m).keys[slot] != CPA_HASH_EMPTY)
+    {
+        if((*m).keys[slot] == key)
+        {
+            return (*m).vals[slot];
+        }
+        slot = (slot + 1) & ((*m).size - 1);
+    }
+
+    (*m).keys[slot] = key;
+    (*m).vals[slot] = val;
+    (*m).used ++;
+
+    return val;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/*
+Cell neighbor graph of a cell thread in compressed sparse row (CSR) format.
+The neighbors of cell c are nbs[offset[c]] ... nbs[offset[c+1]-1].
+The graph is built once and cached across time steps, it is only rebuilt if
+the cell counts of the thread change (mesh adaption), a new case is read or 
+CPAD_RESET_oD is executed. The edge / vertex neighbors are only built if the
+connectivity requires them (and rebuilt if it is changed at runtime).
+The boundary zones of the cells and the cells next to exterior cells are 
+cached as well, so the property reduction does not loop over the faces and 
+neighbors of every cell. The cells sharing a face with an exterior cell are 
+the partition interface cells of the compute node (execute CPAD_RESET_oD 
+after repartitioning or load balancing).
+*/
+
+struct CpaAdjacency
+{
+    Thread  *ct;
+    int     no_int_cells;               /* THREAD_N_ELEMENTS_INT at build time */
+    int     no_ext_cells;               /* THREAD_N_ELEMENTS_EXT at build time */
+    int     *face_offset;               /* face neighbors */
+    cell_t  *face_nbs;
+    int     *node_offset;               /* edge or vertex neighbors */
+    cell_t  *node_nbs;                  /* (incl. face neighbors) */
+    int     node_connectivity;          /* of node_nbs, CPA_CONNECT_FACE: not built */
+    int     *bnd_offset;                /* boundary zone id of every boundary face */
+    int     *bnd_ids;                   /* of the interior cells */
+    int     *par_offset;                /* exterior face neighbors of the interior */
+    cell_t  *par_nbs;                   /* cells (partition interface) and the */
+    face_t  *par_faces;                 /* global ids of the connecting faces */
+    cpa_bits_t *ext_bits;               /* interior cells with exterior neighbors */
+    int     ext_connectivity;           /* of ext_bits, -1: not built */
+};
+
+static struct CpaAdjacency cpa_adjacency_cache[CPA_MAX_CACHED_THREADS];
+static int cpa_no_cached_adjacencies = 0;
+
+
+void freeCpaAdjacency(struct CpaAdjacency *g)
+{
+    if((*g).face_offset != NULL) free((*g).face_offset);
+    if((*g).face_nbs != NULL) free((*g).face_nbs);
+    if((*g).node_offset != NULL) free((*g).node_offset);
+    if((*g).node_nbs != NULL) free((*g).node_nbs);
+    if((*g).bnd_offset != NULL) free((*g).bnd_offset);
+    if((*g).bnd_ids != NULL) free((*g).bnd_ids);
+    if((*g).par_offset != NULL) free((*g).par_offset);
+    if((*g).par_nbs != NULL) free((*g).par_nbs);
+    if((*g).par_faces != NULL) free((*g).par_faces);
+    if((*g).ext_bits != NULL) free((*g).ext_bits);
+
+    (*g).face_offset = NULL;
+    (*g).face_nbs = NULL;
+    (*g).node_offset = NULL;
+    (*g).node_nbs = NULL;
+    (*g).node_connectivity = CPA_CONNECT_FACE;
+    (*g).bnd_offset = NULL;
+    (*g).bnd_ids = NULL;
+    (*g).par_offset = NULL;
+    (*g).par_nbs = NULL;
+    (*g).par_faces = NULL;
+    (*g).ext_bits = NULL;
+    (*g).ext_connectivity = -1;
+    (*g).ct = NULL;
+}
+
+
+void invalidateCpaAdjacencyCache()
+{
+    int i;
+
+    for(i = 0; i < cpa_no_cached_adjacencies; ++i)
+    {
+        freeCpaAdjacency(&(cpa_adjacency_cache[i]));
+    }
+
+    cpa_no_cached_adjacencies = 0;
+}
+
+
+int buildCpaFaceAdjacencyCSR(
+                            Thread *ct,
+                            cell_t nocells_ct,
+                            struct CpaAdjacency *g
+                            )
+{
+/*
+    Two passes over all (interior and exterior) cells of ct: count face 
+    neighbors, then fill. Duplicate neighbors are dropped, the order of first
+    occurrence is kept. The boundary zone ids of the interior cells and their
+    exterior neighbors with the connecting faces (partition interface) are 
+    collected in the same loops over the cell faces.
+*/
+    int state = STATE_OK;
+    cell_t c;
+    int i, j, k, n, m;
+    int no_int_cells = THREAD_N_ELEMENTS_INT(ct);
+    cell_t c0nc_array[NO_MAX_CELL_FACE_NEIGHBOR_CELLS];
+    face_t c0nf_array[NO_MAX_CELL_FACE_NEIGHBOR_CELLS];
+    int c0bid_array[NO_MAX_CELL_FACE_NEIGHBOR_CELLS];
+    int c0nc_array_size = 0;
+    int c0bid_array_size = 0;
+    int pass;
+
+    (*g).face_offset = (int*) calloc(nocells_ct + 1, sizeof(int));
+    (*g).bnd_offset = (int*) calloc(no_int_cells + 1, sizeof(int));
+    (*g).par_offset = (int*) calloc(no_int_cells + 1, sizeof(int));
+
+    if((*g).face_offset == NULL || (*g).bnd_offset == NULL || (*g).par_offset == NULL)
+    {
+        DebugMessage("Error (calloc): No free memory for adjacency available!\n");
+        return STATE_ERROR;
+    }
+
+    for(pass = 0; pass < 2 && state == STATE_OK; ++pass)
+    {
+        for(c = 0; c < nocells_ct; ++c)
+        {
+            getCellsFaceNeighborCells(c, ct, nocells_ct, c0nc_array, c0nf_array, 
+                                        &c0nc_array_size, c0bid_array, &c0bid_array_size);
+
+            n = 0;
+            m = 0;
+
+            for(i = 0; i < c0nc_array_size; ++i)
+            {
+                for(j = 0; j < i; ++j)
+                {
+                    if(c0nc_array[j] == c0nc_array[i])
+                    {
+                        break;
+                    }
+                }
+
+                if(j == i && c0nc_array[i] != c)
+                {
+                    if(pass == 1)
+                    {
+                        (*g).face_nbs[(*g).face_offset[c] + n] = c0nc_array[i];
+                    }
+                    n++;
+
+                    if(c < no_int_cells && c0nc_array[i] >= no_int_cells)
+                    {
+                        if(pass == 1)
+                        {
+                            (*g).par_nbs[(*g).par_offset[c] + m] = c0nc_array[i];
+                            (*g).par_faces[(*g).par_offset[c] + m] = c0nf_array[i];
+                        }
+                        m++;
+                    }
+                }
+            }
+
+            if(c < no_int_cells)
+            {
+                for(i = 0; i < c0bid_array_size && pass == 1; ++i)
+                {
+                    (*g).bnd_ids[(*g).bnd_offset[c] + i] = c0bid_array[i];
+                }
+
+                if(pass == 0)
+                {
+                    (*g).bnd_offset[c+1] = c0bid_array_size;
+                    (*g).par_offset[c+1] = m;
+                }
+            }
+
+            if(pass == 0)
+            {
+                (*g).face_offset[c+1] = n;
+            }
+        }
+
+        if(pass == 0)
+        {
+            for(k = 0; k < nocells_ct; ++k)
+            {
+                (*g).face_offset[k+1] += (*g).face_offset[k];
+            }
+
+            for(k = 0; k < no_int_cells; ++k)
+            {
+                (*g).bnd_offset[k+1] += (*g).bnd_offset[k];
+                (*g).par_offset[k+1] += (*g).par_offset[k];
+            }
+
+            (*g).face_nbs = (cell_t*) malloc(((*g).face_offset[nocells_ct] + 1) 
+                                                * sizeof(cell_t));
+            (*g).bnd_ids = (int*) malloc(((*g).bnd_offset[no_int_cells] + 1) * sizeof(int));
+            (*g).par_nbs = (cell_t*) malloc(((*g).par_offset[no_int_cells] + 1) 
+                                                * sizeof(cell_t));
+            (*g).par_faces = (face_t*) malloc(((*g).par_offset[no_int_cells] + 1) 
+                                                * sizeof(face_t));
+
+            if((*g).face_nbs == NULL || (*g).bnd_ids == NULL || (*g).par_nbs == NULL 
+                || (*g).par_faces == NULL)
+            {
+                DebugMessage("Error (malloc): No free memory for adjacency available!\n");
+                state = STATE_ERROR;
+            }
+        }
+    }
+
+    return state;
+}
+
+
+int buildCpaNodeAdjacencyCSR(
+                            Thread *ct,
+                            cell_t nocells_ct,
+                            int min_shared_nodes,
+                            int *face_offset,
+                            cell_t *face_nbs,
+                            int **offset,
+                            cell_t **nbs
+                            )
+{
+/*
+    Neighbors sharing at least min_shared_nodes nodes with a cell (2: edge, 
+    1: vertex connectivity), determined from the cell node loops:
+        1. number the nodes of ct (hash map node pointer -> index) 
+        2. node -> cells lists (CSR)
+        3. count the nodes shared with all cells around the nodes of a cell
+    The face neighbors are always included and listed first.
+*/
+    int state = STATE_OK;
+    struct CpaHashMap node_map;
+    int *cn_offset = NULL;                  /* cell -> node indices */
+    int *cn = NULL;
+    int *nc_offset = NULL;                  /* node -> cells */
+    cell_t *nc = NULL;
+    int *shared = NULL;                     /* shared nodes per cell (scratch) */
+    cell_t *touched = NULL;
+    int touched_capacity = 0, no_touched;
+    int no_nodes = 0, capacity = 0, used = 0;
+    cell_t c, x;
+    int i, j, k, n, v;
+    cell_t *new_nbs = NULL;
+
+    *offset = NULL;
+    *nbs = NULL;
+
+    cn_offset = (int*) calloc(nocells_ct + 1, sizeof(int));
+    shared = (int*) calloc(nocells_ct > 0 ? nocells_ct : 1, sizeof(int));
+
+    if(cn_offset == NULL || shared == NULL 
+        || initCpaHashMap(&node_map, 2*nocells_ct) != STATE_OK)
+    {
+        DebugMessage("Error (calloc): No free memory for node adjacency available!\n");
+        state = STATE_ERROR;
+    }
+
+    /* 1. cell -> node indices */
+    if(state == STATE_OK)
+    {
+        for(c = 0; c < nocells_ct; ++c)
+        {
+            cn_offset[c+1] = cn_offset[c] + C_NNODES(c, ct);
+        }
+
+        cn = (int*) malloc((cn_offset[nocells_ct] + 1) * sizeof(int));
+
+        if(cn == NULL)
+        {
+            state = STATE_ERROR;
+        }
+    }
+
+    for(c = 0; c < nocells_ct && state == STATE_OK; ++c)
+    {
+        c_node_loop(c, ct, n)
+        {
+            v = cpaHashMapInsert(&node_map, (size_t) C_NODE(c, ct, n), no_nodes);
+
+            if(v == no_nodes)
+            {
+                no_nodes ++;
+            }
+            else if(v < 0)
+            {
+                state = STATE_ERROR;
+                break;
+            }
+
+            cn[cn_offset[c] + n] = v;
+        }
+    }
+
+    freeCpaHashMap(&node_map);
+
+    /* 2. node -> cells */
+    if(state == STATE_OK)
+    {
+        nc_offset = (int*) calloc(no_nodes + 1, sizeof(int));
+        nc = (cell_t*) malloc((cn_offset[nocells_ct] + 1) * sizeof(cell_t));
+
+        if(nc_offset == NULL || nc == NULL)
+        {
+            state = STATE_ERROR;
+        }
+    }
+
+    if(state == STATE_OK)
+    {
+        for(k = 0; k < cn_offset[nocells_ct]; ++k)
+        {
+            nc_offset[cn[k] + 1] ++;
+        }
+
+        for(v = 0; v < no_nodes; ++v)
+        {
+            nc_offset[v+1] += nc_offset[v];
+        }
+
+        for(c = 0; c < nocells_ct; ++c)
+        {
+            for(k = cn_offset[c]; k < cn_offset[c+1]; ++k)
+            {
+                nc[nc_offset[cn[k]]++] = c;
+            }
+        }
+
+        for(v = no_nodes; v > 0; --v)       /* restore offsets */
+        {
+            nc_offset[v] = nc_offset[v-1];
+        }
+        nc_offset[0] = 0;
+
+        *offset = (int*) calloc(nocells_ct + 1, sizeof(int));
+
+        if(*offset == NULL)
+        {
+            state = STATE_ERROR;
+        }
+    }
+
+    /* 3. neighbors by shared node count */
+    for(c = 0; c < nocells_ct && state == STATE_OK; ++c)
+    {
+        no_touched = 0;
+
+        for(i = face_offset[c]; i < face_offset[c+1]; ++i)
+        {
+            shared[face_nbs[i]] = -1;       /* listed already */
+        }
+
+        for(k = cn_offset[c]; k < cn_offset[c+1] && state == STATE_OK; ++k)
+        {
+            for(j = nc_offset[cn[k]]; j < nc_offset[cn[k]+1]; ++j)
+            {
+                x = nc[j];
+
+                if(x != c && shared[x] >= 0)
+                {
+                    if(shared[x] == 0)
+                    {
+                        if(no_touched == touched_capacity)
+                        {
+                            touched_capacity = (touched_capacity > 0) ? 2*touched_capacity : 64;
+                            new_nbs = (cell_t*) realloc(touched, touched_capacity * sizeof(cell_t));
+
+                            if(new_nbs == NULL)
+                            {
+                                state = STATE_ERROR;
+                                break;
+                            }
+                            touched = new_nbs;
+                        }
+                        touched[no_touched++] = x;
+                    }
+                    shared[x] ++;
+                }
+            }
+        }
+
+        n = face_offset[c+1] - face_offset[c] + no_touched;
+
+        if(state == STATE_OK && used + n > capacity)
+        {
+            capacity = (capacity > 0) ? 2*capacity : 8*nocells_ct + 64;
+
+            while(used + n > capacity)
+            {
+                capacity *= 2;
+            }
+
+            new_nbs = (cell_t*) realloc(*nbs, capacity * sizeof(cell_t));
+
+            if(new_nbs == NULL)
+            {
+                state = STATE_ERROR;
+            }
+            else
+            {
+                *nbs = new_nbs;
+            }
+        }
+
+        for(i = face_offset[c]; i < face_offset[c+1]; ++i)
+        {
+            if(state == STATE_OK)
+            {
+                (*nbs)[used++] = face_nbs[i];
+            }
+            shared[face_nbs[i]] = 0;
+        }
+
+        for(i = 0; i < no_touched; ++i)
+        {
+            if(state == STATE_OK && shared[touched[i]] >= min_shared_nodes)
+            {
+                (*nbs)[used++] = touched[i];
+            }
+            shared[touched[i]] = 0;
+        }
+
+        (*offset)[c+1] = used;
+    }
+
+    if(state != STATE_OK)
+    {
+        DebugMessage("Error (malloc): No free memory for node adjacency available!\n");
+    }
+
+    if(cn_offset != NULL) free(cn_offset);
+    if(cn != NULL) free(cn);
+    if(nc_offset != NULL) free(nc_offset);
+    if(nc != NULL) free(nc);
+    if(shared != NULL) free(shared);
+    if(touched != NULL) free(touched);
+
+    return state;
+}
+
+
+int markCpaExteriorNeighbors(
+                            cpa_bits_t **bits,
+                            int no_int_cells,
+                            int *nb_offset,
+                            cell_t *nbs
+                            )
+{
+/*
+    Set the bits of the interior cells with exterior neighbors (cells of 
+    other compute nodes) in the neighbor graph nb_offset / nbs
+*/
+    cell_t c;
+    int cci;
+
+    if(*bits == NULL)
+    {
+        *bits = (cpa_bits_t*) malloc((CPA_BIT_WORDS(no_int_cells) + 1) 
+                                        * sizeof(cpa_bits_t));
+
+        if(*bits == NULL)
+        {
+            DebugMessage("Error (malloc): No free memory for adjacency available!\n");
+            return STATE_ERROR;
+        }
+    }
+
+    memset(*bits, 0, (CPA_BIT_WORDS(no_int_cells) + 1) * sizeof(cpa_bits_t));
+
+    for(c = 0; c < no_int_cells; ++c)
+    {
+        for(cci = nb_offset[c]; cci < nb_offset[c+1]; ++cci)
+        {
+            if(nbs[cci] >= no_int_cells)
+            {
+                CPA_BIT_SET(*bits, c);
+                break;
+            }
+        }
+    }
+
+    return STATE_OK;
+}
+
+
+struct CpaAdjacency *cpaAdjacencyExtBits(struct CpaAdjacency *g, int connectivity)
+{
+/*
+    Mark the interior cells with exterior neighbors in the neighbor graph of
+    the connectivity (face neighbors are included in all graphs), returns g 
+    or NULL if out of memory
+*/
+    if((*g).ext_connectivity == connectivity)
+    {
+        return g;
+    }
+
+    if(connectivity == CPA_CONNECT_FACE)
+    {
+        if(markCpaExteriorNeighbors(&((*g).ext_bits), (*g).no_int_cells, 
+                                    (*g).face_offset, (*g).face_nbs) != STATE_OK)
+        {
+            return NULL;
+        }
+    }
+    else if(markCpaExteriorNeighbors(&((*g).ext_bits), (*g).no_int_cells, 
+                                    (*g).node_offset, (*g).node_nbs) != STATE_OK)
+    {
+        return NULL;
+    }
+
+    (*g).ext_connectivity = connectivity;
+
+    return g;
+}
+
+
+struct CpaAdjacency *getCpaAdjacency(Thread *ct, int connectivity)
+{
+/*
+    Return the cached adjacency of cell thread ct for the given connectivity,
+    (re)build it if necessary
+*/
+    int i;
+    int state = STATE_OK;
+    struct CpaAdjacency *g = NULL;
+    struct CpaAdjacency *free_g = NULL;
+    cell_t nocells_ct = THREAD_N_ELEMENTS_INT(ct) + THREAD_N_ELEMENTS_EXT(ct);
+
+    for(i = 0; i < cpa_no_cached_adjacencies; ++i)
+    {
+        if(cpa_adjacency_cache[i].ct == ct)
+        {
+            g = &(cpa_adjacency_cache[i]);
+            break;
+        }
+        else if(cpa_adjacency_cache[i].ct == NULL && free_g == NULL)
+        {
+            free_g = &(cpa_adjacency_cache[i]);
+        }
+    }
+
+    if(g != NULL 
+        && (*g).no_int_cells == THREAD_N_ELEMENTS_INT(ct)
+        && (*g).no_ext_cells == THREAD_N_ELEMENTS_EXT(ct))
+    {
+        if(connectivity == CPA_CONNECT_FACE || (*g).node_connectivity == connectivity)
+        {
+            return cpaAdjacencyExtBits(g, connectivity);
+        }
+
+        /* connectivity changed, only the node neighbors are rebuilt */
+        if((*g).node_offset != NULL) free((*g).node_offset);
+        if((*g).node_nbs != NULL) free((*g).node_nbs);
+        (*g).node_offset = NULL;
+        (*g).node_nbs = NULL;
+        (*g).node_connectivity = CPA_CONNECT_FACE;
+
+        state = buildCpaNodeAdjacencyCSR(ct, nocells_ct, 
+                            (connectivity == CPA_CONNECT_EDGE) ? 2 : 1,
+                            (*g).face_offset, (*g).face_nbs, 
+                            &((*g).node_offset), &((*g).node_nbs));
+
+        if(state != STATE_OK)
+        {
+            freeCpaAdjacency(g);
+            return NULL;
+        }
+
+        (*g).node_connectivity = connectivity;
+        return cpaAdjacencyExtBits(g, connectivity);
+    }
+
+    if(g == NULL && free_g != NULL)
+    {
+        g = free_g;
+    }
+    else if(g == NULL)
+    {
+        if(cpa_no_cached_adjacencies >= CPA_MAX_CACHED_THREADS)
+        {
+            Message("Error getCpaAdjacency(): Too many cell threads (max. %i)!\n", 
+                        CPA_MAX_CACHED_THREADS);
+            return NULL;
+        }
+
+        g = &(cpa_adjacency_cache[cpa_no_cached_adjacencies]);
+        cpa_no_cached_adjacencies ++;
+        (*g).face_offset = NULL;
+        (*g).face_nbs = NULL;
+        (*g).node_offset = NULL;
+        (*g).node_nbs = NULL;
+        (*g).node_connectivity = CPA_CONNECT_FACE;
+        (*g).bnd_offset = NULL;
+        (*g).bnd_ids = NULL;
+        (*g).par_offset = NULL;
+        (*g).par_nbs = NULL;
+        (*g).par_faces = NULL;
+        (*g).ext_bits = NULL;
+        (*g).ext_connectivity = -1;
+    }
+    else
+    {
+        freeCpaAdjacency(g); /* mesh changed */
+    }
+
+    Message("Building cell adjacency of thread %i in myid %i\n", THREAD_ID(ct), myid);
+
+    state = buildCpaFaceAdjacencyCSR(ct, nocells_ct, g);
+
+    if(state == STATE_OK && connectivity != CPA_CONNECT_FACE)
+    {
+        state = buildCpaNodeAdjacencyCSR(ct, nocells_ct, 
+                            (connectivity == CPA_CONNECT_EDGE) ? 2 : 1,
+                            (*g).face_offset, (*g).face_nbs, 
+                            &((*g).node_offset), &((*g).node_nbs));
+    }
+
+    if(state != STATE_OK)
+    {
+        freeCpaAdjacency(g);
+        return NULL;   /* entry stays unused (ct == NULL) and is rebuilt next call */
+    }
+
+    (*g).node_connectivity = connectivity;
+
+    (*g).ct = ct;
+    (*g).no_int_cells = THREAD_N_ELEMENTS_INT(ct);
+    (*g).no_ext_cells = THREAD_N_ELEMENTS_EXT(ct);
+
+    if(cpaAdjacencyExtBits(g, connectivity) == NULL)
+    {
+        freeCpaAdjacency(g);
+        return NULL;
+    }
+
+    return g;
+}
+
+/*----------------------------------------------------------------------------*/
+
+int updateCpaCellProperties(
+                            struct Cpa *d,
+                            cell_t *cells,
+                            int lo,
+                            int hi,
+                            Thread *ct,
+                            Thread *ptp,
+                            struct CpaAdjacency *adj,
+                            struct CpaArena *a
+                            )
+{
+/*
+    Add mass, volume, alpha, center of mass weights and boundary zones of
+    the cells lo..hi-1 of the cell list to cpa d (ptp: phase thread of the 
+    detected phase), returns the number of boundary faces of the cells.
+
+    The cell values are gathered in blocks of CPA_REDUCE_CHUNK cells, so the
+    products are computed in loops without dependencies (vectorized by the
+    compiler); the sums are added in the order of the cells, so the results
+    do not depend on the block size.
+*/
+    real alpha[CPA_REDUCE_CHUNK];
+    real c_vol[CPA_REDUCE_CHUNK];
+    real c_mass[CPA_REDUCE_CHUNK];
+    real x_c[ND_ND][CPA_REDUCE_CHUNK];
+    real x[ND_ND];
+    real mass = (*d).mass;
+    real vol = (*d).vol;
+    real alpha_sum = (*d).alpha_mean;
+    real alpha_max = (*d).alpha_max;
+    real weights[ND_ND];
+    cell_t cx;
+    int i, j, k, n, bi;
+    int no_updates = 0;
+
+    for(j = 0; j < ND_ND; ++j)
+    {
+        weights[j] = (*d).sumed_com_cell_weights[j];
+    }
+
+    for(i = lo; i < hi; i += n)
+    {
+        n = (hi - i < CPA_REDUCE_CHUNK) ? hi - i : CPA_REDUCE_CHUNK;
+
+        for(k = 0; k < n; ++k)
+        {
+            cx = cells[i + k];
+            alpha[k] = C_VOF(cx, ptp);
+            c_vol[k] = C_VOLUME(cx, ct);
+            c_mass[k] = C_R(cx, ptp);
+            C_CENTROID(x, cx, ct);
+
+            for(j = 0; j < ND_ND; ++j)
+            {
+                x_c[j][k] = x[j];
+            }
+        }
+
+        for(k = 0; k < n; ++k)
+        {
+            c_vol[k] = alpha[k] * c_vol[k];
+            c_mass[k] = c_vol[k] * c_mass[k];
+        }
+
+        for(j = 0; j < ND_ND; ++j)
+        {
+            for(k = 0; k < n; ++k)
+            {
+                x_c[j][k] = x_c[j][k] * c_mass[k];
+            }
+        }
+
+        for(k = 0; k < n; ++k)
+        {
+            alpha_max = (alpha_max < alpha[k]) ? alpha[k] : alpha_max;
+        }
+
+        for(k = 0; k < n; ++k)
+        {
+            mass += c_mass[k];
+            vol += c_vol[k];
+            alpha_sum += alpha[k];
+        }
+
+        for(j = 0; j < ND_ND; ++j)
+        {
+            for(k = 0; k < n; ++k)
+            {
+                weights[j] += x_c[j][k];
+            }
+        }
+    }
+
+    (*d).mass = mass;
+    (*d).vol = vol;
+    (*d).alpha_mean = alpha_sum;
+    (*d).alpha_max = alpha_max;
+
+    for(j = 0; j < ND_ND; ++j)
+    {
+        (*d).sumed_com_cell_weights[j] = weights[j];
+    }
+
+    for(i = lo; i < hi; ++i)
+    {
+        cx = cells[i];
+
+        for(bi = (*adj).bnd_offset[cx]; bi < (*adj).bnd_offset[cx+1]; ++bi)
+        {
+            updateCpaBoundaryID_List(d, (*adj).bnd_ids[bi], a);
+            no_updates ++;
+        }
+    }
+
+    return no_updates;
+}
+
+
+int updateCpaPartitionBoundary(
+                                struct Cpa *d,
+                                cell_t cx,
+                                Thread *ct,
+                                Thread *ptp,
+                                struct CpaAdjacency *adj,
+                                struct CpaArena *a
+                                )
+{
+/*
+    Add partition boundary faces of cell cx to cpa d if the cell on the other
+    side of the face also belongs to the detected phase, returns the number
+    of added faces
+*/
+    cell_t ci;
+    int cci;
+    int no_updates = 0;
+    real min_vol_frac = cpa_config.min_vol_frac;
+
+    /* exterior face neighbors of cx with the connecting faces, see 
+       buildCpaFaceAdjacencyCSR() */
+    for(cci=(*adj).par_offset[cx]; cci<(*adj).par_offset[cx+1]; ++cci)
+    {
+        ci = (*adj).par_nbs[cci];
+
+        if (C_PART(ci, ct) != myid && C_VOF(ci, ptp) > min_vol_frac)
+        {
+            updateCpaParBoundaryFaceID_List(d, (*adj).par_faces[cci], a);
+
+            updateCpaParBoundaryRankList(d, (int) C_PART(ci, ct), a);
+            no_updates ++;
+        }
+    }
+
+    return no_updates;
+}
+
+
+void updateCpaParCells(
+                        struct Cpa *d,
+                        cell_t cx,
+                        Thread *ct,
+                        Thread *ptp,
+                        struct CpaAdjacency *adj,
+                        struct CpaArena *a
+                        )
+{
+/*
+    Add the exterior cells (cells of other compute nodes) of the detected 
+    phase connected to cell cx with the selected connectivity to cpa d and 
+    cx itself as cell on the partition boundary. With the exterior cell 
+    layer the stitching of cpas across compute nodes works for face, edge 
+    and vertex connectivity, see cpaGlobalCpas()
+*/
+    cell_t ci;
+    int cci;
+    int touches = 0;
+    real min_vol_frac = cpa_config.min_vol_frac;
+    int *nb_offset = (*adj).face_offset;
+    cell_t *nbs = (*adj).face_nbs;
+
+    if(cpa_config.connectivity != CPA_CONNECT_FACE)
+    {
+        nb_offset = (*adj).node_offset;
+        nbs = (*adj).node_nbs;
+    }
+
+    for(cci=nb_offset[cx]; cci<nb_offset[cx+1]; ++cci)
+    {
+        ci = nbs[cci];
+
+        if(ci >= (*adj).no_int_cells && C_PART(ci, ct) != myid 
+            && C_VOF(ci, ptp) > min_vol_frac)
+        {
+            cpaIntListAppend(&((*d).par_ext_cells), &((*d).no_par_ext_cells), 
+                                &((*d).par_ext_cells_capacity), (int) C_ID(ci, ct), a);
+            touches = 1;
+        }
+    }
+
+    if(touches)
+    {
+        cpaIntListAppend(&((*d).par_cells), &((*d).no_par_cells), 
+                            &((*d).par_cells_capacity), (int) C_ID(cx, ct), a);
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+
+int cpaReduceCpa(	/* returns the number of boundary updates */
+                    struct Cpa *D,
+                    cell_t *cells,
+                    int lo,
+                    int hi,
+                    Thread *ct,
+                    Thread *ptp,
+                    struct CpaAdjacency *adj,
+                    struct CpaArena *a
+                    )
+{
+    int dci;
+    int no_updates = 0;
+    int all_cells = ((*adj).ext_connectivity != cpa_config.connectivity);
+
+    no_updates += updateCpaCellProperties(D, cells, lo, hi, ct, ptp, adj, a);
+
+    /* only cells next to exterior cells can touch the partition boundary */
+    for (dci = lo;  dci < hi; dci++)
+    {
+        if(all_cells || CPA_BIT_TEST((*adj).ext_bits, cells[dci]))
+        {
+            no_updates += updateCpaPartitionBoundary(D, cells[dci], ct, ptp, adj, a);
+            #if _STITCH
+            updateCpaParCells(D, cells[dci], ct, ptp, adj, a);
+            #endif
+        }
+    }
+
+    return no_updates;
+}
+
+
+int cpaReduceCpas(
+                    Thread *ct,
+                    Thread *ptp,
+                    struct CpaAdjacency *adj,
+                    struct CpaList *DList,
+                    int first_cpa,
+                    struct CpaArena *a
+                    )
+{
+/*
+    Accumulate the properties of cpas first_cpa ... of DList from their 
+    (sorted) cell lists and finalize them. With OpenMP small cpas are 
+    distributed over the threads, cpas with more than CPA_OMP_BIG_CPA_CELLS 
+    cells (e.g. a liquid sheet) are split over all threads and the partial 
+    sums are merged in thread order. Every thread allocates from its own 
+    arena, the blocks are handed over to a afterwards.
+*/
+    int state = STATE_OK;
+    int k, t, nt;
+    int no_threads = CPA_MAX_THREADS;
+    long no_updates = 0;
+    struct CpaArena *thread_arena = NULL;
+    struct Cpa *part = NULL;
+    struct Cpa *D = NULL;
+
+    if(no_threads <= 1)
+    {
+        for(k = first_cpa; k < (*DList).no_cpas; ++k)
+        {
+            D = &((*DList).cpas[k]);
+            no_updates += cpaReduceCpa(D, (*D).cell_list, 0, (*D).no_cells, ct, ptp, adj, a);
+            finalizeCpa(D);
+        }
+
+        cpa_timings.no_boundary_updates += no_updates;
+        return state;
+    }
+
+    thread_arena = (struct CpaArena*) malloc(no_threads * sizeof(struct CpaArena));
+    part = (struct Cpa*) malloc(no_threads * sizeof(struct Cpa));
+
+    if(thread_arena == NULL || part == NULL)
+    {
+        DebugMessage("Error (malloc): No free memory for thread arenas available!\n");
+        if(thread_arena != NULL) free(thread_arena);
+        if(part != NULL) free(part);
+        return STATE_ERROR;
+    }
+
+    for(t = 0; t < no_threads; ++t)
+    {
+        initCpaArena(&(thread_arena[t]));
+    }
+
+    /* small cpas, one thread per cpa */
+    #pragma omp parallel for schedule(dynamic, 16) private(D) num_threads(no_threads) \
+                reduction(+:no_updates)
+    for(k = first_cpa; k < (*DList).no_cpas; ++k)
+    {
+        D = &((*DList).cpas[k]);
+
+        if((*D).no_cells < CPA_OMP_BIG_CPA_CELLS)
+        {
+            no_updates += cpaReduceCpa(D, (*D).cell_list, 0, (*D).no_cells, ct, ptp, adj, 
+                                        &(thread_arena[CPA_THREAD_NUM]));
+            finalizeCpa(D);
+        }
+    }
+
+    /* big cpas, all threads per cpa */
+    for(k = first_cpa; k < (*DList).no_cpas; ++k)
+    {
+        D = &((*DList).cpas[k]);
+
+        if((*D).no_cells >= CPA_OMP_BIG_CPA_CELLS)
+        {
+            nt = 1;
+
+            #pragma omp parallel private(t) num_threads(no_threads) reduction(+:no_updates)
+            {
+                t = CPA_THREAD_NUM;
+
+                #pragma omp single
+                nt = CPA_NUM_THREADS;
+
+                resetCpa(&(part[t]));
+                no_updates += cpaReduceCpa(&(part[t]), (*D).cell_list,
+                                (int) (((double) (*D).no_cells * t) / nt),
+                                (int) (((double) (*D).no_cells * (t+1)) / nt), 
+                                ct, ptp, adj, &(thread_arena[t]));
+            }
+
+            for(t = 0; t < nt; ++t)
+            {
+                mergeCpa(D, &(part[t]), a);
+            }
+
+            finalizeCpa(D);
+        }
+    }
+
+    for(t = 0; t < no_threads; ++t)
+    {
+        cpaArenaAdopt(a, &(thread_arena[t]));
+    }
+
+    free(thread_arena);
+    free(part);
+
+    cpa_timings.no_boundary_updates += no_updates;
+    return state;
+}
+
+/*----------------------------------------------------------------------------*/
+
+int cpaFloodFill(
+                Thread *ct,
+                Thread *ptp,
+                struct CpaAdjacency *adj,
+                int *nb_offset,
+                cell_t *nbs,
+                struct CpaList *DList,
+                struct CpaArena *a
+                )
+{
+/*
+    Seed and grow labelling: every unchecked interior cell above the volume
+    fraction limit starts a new cpa, which is grown over the neighbor graph
+*/
+    int state = STATE_OK;
+    cell_t c, cx, ci;
+    int cci, dci;
+    struct Cpa *D = NULL;                   /*Single Cpa (in DList)*/
+    cpa_bits_t *above = NULL;               /*interior cells above the limit*/
+    cpa_bits_t *visited = NULL;
+    int first_cpa = (*DList).no_cpas;
+    long no_lookups = 0;
+    double t_start;
+
+    if(cpaCellBits(ct, ptp, cpa_config.min_vol_frac,
+                   (CPA_MAX_THREADS > 1 && THREAD_N_ELEMENTS_INT(ct) >= CPA_OMP_MIN_CELLS),
+                   &above, &visited) != STATE_OK)
+    {
+        return STATE_ERROR;
+    }
+
+    begin_c_loop_int(c, ct)
+    {
+        /* find initial droplet cell */
+        if (
+            CPA_BIT_TEST(above, c)
+            && !CPA_BIT_TEST(visited, c)
+            && (state == STATE_OK)
+        )
+        {
+            D = cpaListNew(DList, a); /*Cpa is built in place*/
+            state = (D != NULL) ? initCpa(D, c, a) : STATE_ERROR; /*Initital cpa (droplet)*/
+            CPA_BIT_SET(visited, c);
+
+            if (state == STATE_OK)
+            {
+                /* find connected droplet cells */
+                for (dci = 0;  dci < (*D).no_cells; dci++)
+                {
+                    cx = (*D).cell_list[dci];
+                    no_lookups += nb_offset[cx+1] - nb_offset[cx];
+
+                    for(cci=nb_offset[cx]; cci<nb_offset[cx+1]; ++cci)
+                    {
+                        ci = nbs[cci];
+
+                        if(CPA_BIT_TEST(above, ci) && !CPA_BIT_TEST(visited, ci))
+                        {
+                            CPA_BIT_SET(visited, ci);
+                            state = cpaCellsAppend(D, ci, a);
+                        }
+                    }
+                }
+
+                /* properties are reduced in cell index order (sums are
+                   independent of the labelling engine) */
+                qsort((*D).cell_list, (*D).no_cells, sizeof(cell_t), compareInt);
+            }
+        }
+    }end_c_loop_int(c, ct)
+
+    cpa_timings.no_nb_lookups += no_lookups;
+
+    if(state == STATE_OK)
+    {
+        t_start = cpaWallTime();
+        state = cpaReduceCpas(ct, ptp, adj, DList, first_cpa, a);
+        cpa_timings.reduction += cpaWallTime() - t_start;
+    }
+
+    return state;
+}
+
+/*----------------------------------------------------------------------------*/
+
+int cpaFloodFillStats(
+                    Thread *ct,
+                    Thread *ptp,
+                    struct CpaAdjacency *adj,
+                    int *nb_offset,
+                    cell_t *nbs,
+                    struct CpaList *DList,
+                    int udm,
+                    struct CpaArena *a
+                    )
+{
+/*
+    Seed and grow labelling without cell lists (_STATS_ONLY): the cells of a 
+    cpa are only kept in a ring buffer queue until their neighbors are 
+    checked and are reduced in blocks of CPA_REDUCE_CHUNK cells while the 
+    cpa grows. The memory of a cpa does not depend on its number of cells,
+    the queue is bounded by the largest front of the fill. The sums are 
+    added in fill order, so they may differ from the other engines in the 
+    last digits. With udm >= 0 every interior cell gets the local index + 1
+    of its cpa in DList (0: no cpa) in this UDM, see cpaWriteLabels().
+*/
+    int state = STATE_OK;
+    cell_t c, cx, ci;
+    int cci;
+    struct Cpa *D = NULL;                   /*Single Cpa (in DList)*/
+    cpa_bits_t *above = NULL;               /*interior cells above the limit*/
+    cpa_bits_t *visited = NULL;
+    cell_t *queue = NULL;
+    cell_t *grown = NULL;
+    int q_capacity = CPA_MIN_QUEUE_CAPACITY;
+    int q_head = 0;
+    int q_len = 0;
+    cell_t block[CPA_REDUCE_CHUNK];
+    int no_block = 0;
+    int i;
+    long no_lookups = 0;
+    long no_updates = 0;
+    double t_start;
+
+    if(cpaCellBits(ct, ptp, cpa_config.min_vol_frac,
+                   (CPA_MAX_THREADS > 1 && THREAD_N_ELEMENTS_INT(ct) >= CPA_OMP_MIN_CELLS),
+                   &above, &visited) != STATE_OK)
+    {
+        return STATE_ERROR;
+    }
+
+    queue = (cell_t*) malloc(q_capacity * sizeof(cell_t));
+
+    if(queue == NULL)
+    {
+        DebugMessage("Error (malloc): No free memory for fill queue available!\n");
+        return STATE_ERROR;
+    }
+
+    begin_c_loop_int(c, ct)
+    {
+        if(udm >= 0 && !CPA_BIT_TEST(above, c))
+        {
+            C_UDMI(c, ct, udm) = 0.0;
+        }
+
+        /* find initial droplet cell */
+        if (
+            CPA_BIT_TEST(above, c)
+            && !CPA_BIT_TEST(visited, c)
+            && (state == STATE_OK)
+        )
+        {
+            D = cpaListNew(DList, a); /*Cpa is built in place*/
+            state = (D != NULL) ? STATE_OK : STATE_ERROR;
+            CPA_BIT_SET(visited, c);
+            queue[0] = c;
+            q_head = 0;
+            q_len = (state == STATE_OK) ? 1 : 0;
+
+            if (state == STATE_OK)
+            {
+                resetCpa(D);
+            }
+
+            /* find connected droplet cells */
+            while (q_len > 0 && state == STATE_OK)
+            {
+                cx = queue[q_head];
+                q_head = (q_head + 1) & (q_capacity - 1);
+                q_len --;
+                block[no_block++] = cx;
+                no_lookups += nb_offset[cx+1] - nb_offset[cx];
+
+                if(udm >= 0)
+                {
+                    C_UDMI(cx, ct, udm) = (real) (*DList).no_cpas;
+                }
+
+                for(cci=nb_offset[cx]; cci<nb_offset[cx+1]; ++cci)
+                {
+                    ci = nbs[cci];
+
+                    if(CPA_BIT_TEST(above, ci) && !CPA_BIT_TEST(visited, ci))
+                    {
+                        CPA_BIT_SET(visited, ci);
+
+                        if(q_len == q_capacity)
+                        {
+                            grown = (cell_t*) malloc(2 * q_capacity * sizeof(cell_t));
+
+                            if(grown == NULL)
+                            {
+                                DebugMessage("Error (malloc): No free memory for fill "
+                                                "queue available!\n");
+                                state = STATE_ERROR;
+                                break;
+                            }
+
+                            for(i = 0; i < q_len; ++i)
+                            {
+                                grown[i] = queue[(q_head + i) & (q_capacity - 1)];
+                            }
+
+                            free(queue);
+                            queue = grown;
+                            q_head = 0;
+                            q_capacity *= 2;
+                        }
+
+                        queue[(q_head + q_len) & (q_capacity - 1)] = ci;
+                        q_len ++;
+                    }
+                }
+
+                if(no_block == CPA_REDUCE_CHUNK || q_len == 0)
+                {
+                    t_start = cpaWallTime();
+                    no_updates += cpaReduceCpa(D, block, 0, no_block, ct, ptp, adj, a);
+                    cpa_timings.reduction += cpaWallTime() - t_start;
+                    (*D).no_cells += no_block;
+                    no_block = 0;
+                }
+            }
+
+            if (state == STATE_OK)
+            {
+                finalizeCpa(D);
+            }
+        }
+    }end_c_loop_int(c, ct)
+
+    free(queue);
+
+    cpa_timings.no_nb_lookups += no_lookups;
+    cpa_timings.no_boundary_updates += no_updates;
+
+    return state;
+}
+
+/*----------------------------------------------------------------------------*/
+
+cell_t cpaFindRoot(cell_t *parent, cell_t c)	/* find with path halving */
+{
+    while(parent[c] != c)
+    {
+        parent[c] = parent[parent[c]];
+        c = parent[c];
+    }
+
+    return c;
+}
+
+
+void cpaUnion(cell_t *parent, unsigned char *rank, cell_t c0, cell_t c1)	/* union by rank */
+{
+    cell_t r0 = cpaFindRoot(parent, c0);
+    cell_t r1 = cpaFindRoot(parent, c1);
+
+    if(r0 == r1)
+    {
+        return;
+    }
+
+    if(rank[r0] < rank[r1])
+    {
+        parent[r0] = r1;
+    }
+    else if(rank[r0] > rank[r1])
+    {
+        parent[r1] = r0;
+    }
+    else
+    {
+        parent[r1] = r0;
+        rank[r0] ++;
+    }
+}
+
+
+cell_t cpaRootOf(cell_t *parent, cell_t c)	/* find without path compression (read only) */
+{
+    while(parent[c] != c)
+    {
+        c = parent[c];
+    }
+
+    return c;
+}
+
+
+int cpaUnionChunks(
+                    cell_t *parent,
+                    unsigned char *rank,
+                    int no_int_cells,
+                    int *nb_offset,
+                    cell_t *nbs
+                    )
+{
+/*
+    Multi-threaded union of neighboring cells: the interior cells are split
+    into one contiguous chunk per thread. Every thread merges the neighbor 
+    pairs inside its chunk (these unions only touch parents of its chunk) 
+    and stores the pairs crossing the chunk border, which are merged 
+    afterwards by a single thread.
+*/
+    int state = STATE_OK;
+    int no_threads = CPA_MAX_THREADS;
+    cell_t **cross = NULL;                  /*border pairs per thread*/
+    int *no_cross = NULL;
+    int *cross_capacity = NULL;
+    int *cross_state = NULL;                /*error flag per thread*/
+    int t, k;
+
+    cross = (cell_t**) calloc(no_threads, sizeof(cell_t*));
+    no_cross = (int*) calloc(no_threads, sizeof(int));
+    cross_capacity = (int*) calloc(no_threads, sizeof(int));
+    cross_state = (int*) calloc(no_threads, sizeof(int));
+
+    if(cross == NULL || no_cross == NULL || cross_capacity == NULL || cross_state == NULL)
+    {
+        DebugMessage("Error (calloc): No free memory for chunk borders available!\n");
+        state = STATE_ERROR;
+    }
+
+    for(t = 0; t < no_threads && state == STATE_OK; ++t)
+    {
+        cross_state[t] = STATE_OK;
+    }
+
+    if(state == STATE_OK)
+    {
+        #pragma omp parallel num_threads(no_threads)
+        {
+            int th = CPA_THREAD_NUM;
+            int nth = CPA_NUM_THREADS;
+            cell_t lo = (cell_t) (((double) no_int_cells * th) / nth);
+            cell_t hi = (cell_t) (((double) no_int_cells * (th+1)) / nth);
+            cell_t c, ci;
+            int cci;
+            long no_lookups = 0;
+            int capacity;
+            cell_t *grown;
+
+            for(c = lo; c < hi && cross_state[th] == STATE_OK; ++c)
+            {
+                if(parent[c] != -1)
+                {
+                    no_lookups += nb_offset[c+1] - nb_offset[c];
+
+                    for(cci = nb_offset[c]; cci < nb_offset[c+1]; ++cci)
+                    {
+                        ci = nbs[cci];
+
+                        if(ci <= c || ci >= no_int_cells || parent[ci] == -1)
+                        {
+                            continue;
+                        }
+
+                        if(ci < hi)
+                        {
+                            cpaUnion(parent, rank, c, ci);
+                        }
+                        else
+                        {
+                            if(no_cross[th] == cross_capacity[th])
+                            {
+                                capacity = (cross_capacity[th] > 0) ? 
+                                                2*cross_capacity[th] : 1024;
+                                grown = (cell_t*) realloc(cross[th], 
+                                            2 * capacity * sizeof(cell_t));
+
+                                if(grown == NULL)
+                                {
+                                    cross_state[th] = STATE_ERROR;
+                                    break;
+                                }
+                                cross[th] = grown;
+                                cross_capacity[th] = capacity;
+                            }
+
+                            cross[th][2*no_cross[th]] = c;
+                            cross[th][2*no_cross[th] + 1] = ci;
+                            no_cross[th] ++;
+                        }
+                    }
+                }
+            }
+
+            #pragma omp atomic
+            cpa_timings.no_nb_lookups += no_lookups;
+        }
+
+        for(t = 0; t < no_threads; ++t)
+        {
+            if(cross_state[t] != STATE_OK)
+            {
+                state = STATE_ERROR;
+            }
+        }
+    }
+
+    for(t = 0; t < no_threads && state == STATE_OK; ++t)
+    {
+        for(k = 0; k < no_cross[t]; ++k)
+        {
+            cpaUnion(parent, rank, cross[t][2*k], cross[t][2*k + 1]);
+        }
+    }
+
+    if(state != STATE_OK)
+    {
+        DebugMessage("Error (realloc): No free memory for chunk borders available!\n");
+    }
+
+    if(cross != NULL)
+    {
+        for(t = 0; t < no_threads; ++t)
+        {
+            if(cross[t] != NULL) free(cross[t]);
+        }
+        free(cross);
+    }
+    if(no_cross != NULL) free(no_cross);
+    if(cross_capacity != NULL) free(cross_capacity);
+    if(cross_state != NULL) free(cross_state);
+
+    return state;
+}
+
+
+int cpaListsFromForest(
+                        cell_t *parent,
+                        int no_int_cells,
+                        int use_threads,
+                        cell_t *root,
+                        int *root_cpa,
+                        struct CpaList *DList,
+                        struct CpaArena *a
+                        )
+{
+/*
+    Append one cpa per set of the disjoint set forest parent (-1: no cpa 
+    cell) to DList. The cpas are numbered by their lowest cell index (same
+    order as in cpaFloodFill), the cell lists of all cpas are put into one 
+    block in cell index order (root, root_cpa: work arrays of no_int_cells)
+*/
+    int state = STATE_OK;
+    cell_t c, r;
+    int k;
+    int first_cpa = (*DList).no_cpas;
+    int no_labelled = 0;
+    cell_t *cells = NULL;                   /*cells of all cpas (by cpa)*/
+    struct Cpa *D = NULL;
+
+    #ifndef _OPENMP
+    (void) use_threads;                     /* single-threaded build */
+    #endif
+
+    #pragma omp parallel for if(use_threads)
+    for(c = 0; c < no_int_cells; ++c)
+    {
+        root[c] = (parent[c] != -1) ? cpaRootOf(parent, c) : -1;
+        root_cpa[c] = -1;
+    }
+
+    /* number cpas by lowest cell index, count cells */
+    for(c = 0; c < no_int_cells && state == STATE_OK; ++c)
+    {
+        r = root[c];
+
+        if(r != -1)
+        {
+            if(root_cpa[r] == -1)
+            {
+                D = cpaListNew(DList, a);
+
+                if(D == NULL)
+                {
+                    state = STATE_ERROR;
+                    break;
+                }
+
+                resetCpa(D);
+                root_cpa[r] = (*DList).no_cpas - 1;
+            }
+
+            (*DList).cpas[root_cpa[r]].no_cells ++;
+            no_labelled ++;
+        }
+    }
+
+    /* cell lists of all cpas in one block */
+    if(state == STATE_OK)
+    {
+        cells = (cell_t*) cpaArenaAlloc(a, (no_labelled + 1) * sizeof(cell_t));
+
+        if(cells == NULL)
+        {
+            state = STATE_ERROR;
+        }
+        else
+        {
+            for(k = first_cpa; k < (*DList).no_cpas; ++k)
+            {
+                D = &((*DList).cpas[k]);
+                (*D).cell_list = cells;
+                (*D).cell_list_capacity = (*D).no_cells;
+                cells += (*D).no_cells;
+                (*D).no_cells = 0;
+            }
+        }
+    }
+
+    for(c = 0; c < no_int_cells && state == STATE_OK; ++c)
+    {
+        if(root[c] != -1)
+        {
+            D = &((*DList).cpas[root_cpa[root[c]]]);
+            (*D).cell_list[(*D).no_cells] = c;
+            (*D).no_cells ++;
+        }
+    }
+
+    return state;
+}
+
+
+int cpaUnionFind(
+                Domain *domain,
+                Thread *ct,
+                Thread *ptp,
+                struct CpaAdjacency *adj,
+                int *nb_offset,
+                cell_t *nbs,
+                struct CpaList *DList,
+                struct CpaArena *a
+                )
+{
+/*
+    Disjoint set labelling:
+        1. every interior cell above the volume fraction limit is a set
+        2. linear pass over the interior faces of the domain (face
+           connectivity) or the cached neighbor graph (edge/vertex
+           connectivity), cells on both sides are merged. With OpenMP the 
+           neighbor graph is processed in chunks, see cpaUnionChunks()
+        3. cpas are collected from the forest, see cpaListsFromForest(), and 
+           the properties are reduced per cpa
+*/
+    int state = STATE_OK;
+    cell_t c;
+    int no_int_cells = THREAD_N_ELEMENTS_INT(ct);
+    int first_cpa = (*DList).no_cpas;
+    int use_threads = 0;
+    double t_start;
+    cell_t *parent = NULL;                  /*-1: not part of a cpa*/
+    unsigned char *rank = NULL;
+    int *root_cpa = NULL;                   /*cpa index of root cells*/
+    cell_t *root = NULL;                    /*root of each cell*/
+    real min_vol_frac = cpa_config.min_vol_frac;
+    Thread *tf;
+    face_t f;
+    cell_t c0, c1;
+    cell_t ci;
+    int cci;
+
+    use_threads = (CPA_MAX_THREADS > 1 && no_int_cells >= CPA_OMP_MIN_CELLS);
+
+    parent = (cell_t*) malloc((no_int_cells + 1) * sizeof(cell_t));
+    rank = (unsigned char*) calloc(no_int_cells + 1, sizeof(unsigned char));
+    root_cpa = (int*) malloc((no_int_cells + 1) * sizeof(int));
+    root = (cell_t*) malloc((no_int_cells + 1) * sizeof(cell_t));
+
+    if(parent == NULL || rank == NULL || root_cpa == NULL || root == NULL)
+    {
+        DebugMessage("Error (malloc): No free memory for union find available!\n");
+        state = STATE_ERROR;
+    }
+
+    if(state == STATE_OK)
+    {
+        #pragma omp parallel for if(use_threads)
+        for(c = 0; c < no_int_cells; ++c)
+        {
+            parent[c] = (C_VOF(c, ptp) > min_vol_frac) ? c : -1;
+        }
+
+        if(use_threads)
+        {
+            state = cpaUnionChunks(parent, rank, no_int_cells, nb_offset, nbs);
+        }
+        else if(cpa_config.connectivity == CPA_CONNECT_FACE)
+        {
+            thread_loop_f(tf, domain)
+            {
+                if(!BOUNDARY_FACE_THREAD_P(tf))
+                {
+                    cpa_timings.no_nb_lookups += THREAD_N_ELEMENTS_INT(tf);
+
+                    begin_f_loop(f, tf)
+                    {
+                        if(F_C0_THREAD(f, tf) == ct && F_C1_THREAD(f, tf) == ct)
+                        {
+                            c0 = F_C0(f, tf);
+                            c1 = F_C1(f, tf);
+
+                            if(c0 >= 0 && c0 < no_int_cells && c1 >= 0 && c1 < no_int_cells
+                                && parent[c0] != -1 && parent[c1] != -1)
+                            {
+                                cpaUnion(parent, rank, c0, c1);
+                            }
+                        }
+                    }end_f_loop(f, tf)
+                }
+            }
+        }
+        else
+        {
+            for(c = 0; c < no_int_cells; ++c)
+            {
+                if(parent[c] != -1)
+                {
+                    cpa_timings.no_nb_lookups += nb_offset[c+1] - nb_offset[c];
+
+                    for(cci = nb_offset[c]; cci < nb_offset[c+1]; ++cci)
+                    {
+                        ci = nbs[cci];
+
+                        if(ci > c && ci < no_int_cells && parent[ci] != -1)
+                        {
+                            cpaUnion(parent, rank, c, ci);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if(state == STATE_OK)
+    {
+        state = cpaListsFromForest(parent, no_int_cells, use_threads, root, root_cpa, 
+                                    DList, a);
+    }
+
+    if(parent != NULL) free(parent);
+    if(rank != NULL) free(rank);
+    if(root_cpa != NULL) free(root_cpa);
+    if(root != NULL) free(root);
+
+    /* reduction */
+    if(state == STATE_OK)
+    {
+        t_start = cpaWallTime();
+        state = cpaReduceCpas(ct, ptp, adj, DList, first_cpa, a);
+        cpa_timings.reduction += cpaWallTime() - t_start;
+    }
+
+    return state;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/*
+Multi-threshold labelling: the cpas for volume fraction limits t_0 < t_1 < ...
+are nested (every cpa for t_k is part of exactly one cpa for t_j, j < k). The
+cells are sorted into buckets by the highest limit they exceed and added to a
+single disjoint set forest from the highest limit down, so after adding 
+bucket k the forest holds the cpas for limit t_k (a max-tree over alpha cut 
+at the limits). Every cell and neighbor pair is merged once for all limits, 
+only the collection and the reduction of the cpas is done per limit. The 
+cpas of every limit are the same as in a detection with this single limit.
+*/
+
+int cpaThresholdLevel(real alpha, real *limits, int no_limits)
+{
+/*
+    Highest k with alpha > limits[k] (limits sorted ascending), -1 if alpha
+    does not exceed any limit
+*/
+    int k = no_limits - 1;
+
+    while(k >= 0 && !(alpha > limits[k]))
+    {
+        k--;
+    }
+
+    return k;
+}
+
+
+int cpaUnionFindThresholds(
+                Thread *ct,
+                Thread *ptp,
+                struct CpaAdjacency *adj,
+                int *nb_offset,
+                cell_t *nbs,
+                real *limits,
+                int no_limits,
+                struct CpaList *DLists,
+                struct CpaArena *a
+                )
+{
+/*
+    Cpas of ct for all limits (sorted ascending) in one pass, the cpas of
+    limits[k] are appended to DLists[k]
+*/
+    int state = STATE_OK;
+    cell_t c, ci;
+    int i, k, cci, level;
+    int no_int_cells = THREAD_N_ELEMENTS_INT(ct);
+    int first_cpa;
+    long no_lookups = 0;
+    double t_start;
+    real min_vol_frac = cpa_config.min_vol_frac;
+    cell_t *parent = NULL;                  /*-1: not (yet) part of a cpa*/
+    unsigned char *rank = NULL;
+    int *root_cpa = NULL;
+    cell_t *root = NULL;
+    cell_t *bucket_cells = NULL;            /*cells by level*/
+    int bucket_offset[CPA_MAX_THRESHOLDS + 1];
+    int bucket_fill[CPA_MAX_THRESHOLDS];
+
+    parent = (cell_t*) malloc((no_int_cells + 1) * sizeof(cell_t));
+    rank = (unsigned char*) calloc(no_int_cells + 1, sizeof(unsigned char));
+    root_cpa = (int*) malloc((no_int_cells + 1) * sizeof(int));
+    root = (cell_t*) malloc((no_int_cells + 1) * sizeof(cell_t));
+    bucket_cells = (cell_t*) malloc((no_int_cells + 1) * sizeof(cell_t));
+
+    if(parent == NULL || rank == NULL || root_cpa == NULL || root == NULL 
+        || bucket_cells == NULL)
+    {
+        DebugMessage("Error (malloc): No free memory for union find available!\n");
+        state = STATE_ERROR;
+    }
+
+    /* bucket (counting) sort by level */
+    if(state == STATE_OK)
+    {
+        for(k = 0; k <= no_limits; ++k)
+        {
+            bucket_offset[k] = 0;
+        }
+
+        for(c = 0; c < no_int_cells; ++c)
+        {
+            parent[c] = -1;
+            level = cpaThresholdLevel(C_VOF(c, ptp), limits, no_limits);
+
+            if(level >= 0)
+            {
+                bucket_offset[level + 1] ++;
+            }
+        }
+
+        for(k = 0; k < no_limits; ++k)
+        {
+            bucket_offset[k + 1] += bucket_offset[k];
+            bucket_fill[k] = bucket_offset[k];
+        }
+
+        for(c = 0; c < no_int_cells; ++c)
+        {
+            level = cpaThresholdLevel(C_VOF(c, ptp), limits, no_limits);
+
+            if(level >= 0)
+            {
+                bucket_cells[bucket_fill[level]++] = c;
+            }
+        }
+    }
+
+    /* highest limit first, every level adds its cells to the forest */
+    for(k = no_limits - 1; k >= 0 && state == STATE_OK; --k)
+    {
+        for(i = bucket_offset[k]; i < bucket_offset[k + 1]; ++i)
+        {
+            parent[bucket_cells[i]] = bucket_cells[i];
+        }
+
+        for(i = bucket_offset[k]; i < bucket_offset[k + 1]; ++i)
+        {
+            c = bucket_cells[i];
+            no_lookups += nb_offset[c+1] - nb_offset[c];
+
+            for(cci = nb_offset[c]; cci < nb_offset[c+1]; ++cci)
+            {
+                ci = nbs[cci];
+
+                if(ci < no_int_cells && parent[ci] != -1)
+                {
+                    cpaUnion(parent, rank, c, ci);
+                }
+            }
+        }
+
+        first_cpa = DLists[k].no_cpas;
+        state = cpaListsFromForest(parent, no_int_cells, 0, root, root_cpa, 
+                                    &(DLists[k]), a);
+
+        /* reduction with the limit of this level (partition neighbors) */
+        if(state == STATE_OK)
+        {
+            cpa_config.min_vol_frac = limits[k];
+            t_start = cpaWallTime();
+            state = cpaReduceCpas(ct, ptp, adj, &(DLists[k]), first_cpa, a);
+            cpa_timings.reduction += cpaWallTime() - t_start;
+        }
+    }
+
+    cpa_config.min_vol_frac = min_vol_frac;
+    cpa_timings.no_nb_lookups += no_lookups;
+
+    if(parent != NULL) free(parent);
+    if(rank != NULL) free(rank);
+    if(root_cpa != NULL) free(root_cpa);
+    if(root != NULL) free(root);
+    if(bucket_cells != NULL) free(bucket_cells);
+
+    return state;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/*
+Incremental labelling: between two time steps only few cells cross the volume
+fraction limit. The cpa labels of the last call (root cell of the cpa of every
+interior cell) are kept per cell thread and phase and reused: a cell dropping
+below the limit marks its old cpa (may split), a cell rising above it marks
+the old cpas of its neighbors (may merge). Only the cells of marked cpas and
+the new cells are flood filled again, the labels of all other cpas are kept.
+A call is still linear in the cell count: every cell is compared with the
+limit, the labels are scanned to dissolve the marked cpas and to collect the
+cpas, and the properties of all cpas are reduced (the volume fractions of
+their cells change). Only the neighbor lookups of the flood fill are saved.
+The labels are reset (full labelling) if the cell counts, the connectivity or
+the limit change, after CPAD_RESET_oD and when a new case is read.
+*/
+
+struct CpaLabels
+{
+    Thread  *ct;
+    int     phase;
+    int     no_int_cells;               /* THREAD_N_ELEMENTS_INT of the labels */
+    int     connectivity;               /* of the labels */
+    real    min_vol_frac;               /* of the labels */
+    cell_t  *label;                     /* root cell of the cpa, -1: no cpa cell */
+    cell_t  *pending;                   /* cells to label again */
+    cell_t  *stack;
+    unsigned char *affected;            /* by root cell */
+};
+
+static struct CpaLabels cpa_label_cache[CPA_MAX_CACHED_LABELS];
+static int cpa_no_cached_labels = 0;
+
+
+void freeCpaLabels(struct CpaLabels *l)
+{
+    if((*l).label != NULL) free((*l).label);
+    if((*l).pending != NULL) free((*l).pending);
+    if((*l).stack != NULL) free((*l).stack);
+    if((*l).affected != NULL) free((*l).affected);
+
+    (*l).label = NULL;
+    (*l).pending = NULL;
+    (*l).stack = NULL;
+    (*l).affected = NULL;
+    (*l).no_int_cells = -1;
+    (*l).ct = NULL;
+}
+
+
+void invalidateCpaLabelCache()
+{
+    int i;
+
+    for(i = 0; i < cpa_no_cached_labels; ++i)
+    {
+        freeCpaLabels(&(cpa_label_cache[i]));
+    }
+
+    cpa_no_cached_labels = 0;
+}
+
+
+struct CpaLabels *getCpaLabels(Thread *ct, int phase)
+{
+/*
+    Return the labels of the last call for cell thread ct and phase, the 
+    labels are empty (all cells -1) if they cannot be reused
+*/
+    int i;
+    int no_int_cells = THREAD_N_ELEMENTS_INT(ct);
+    struct CpaLabels *l = NULL;
+    struct CpaLabels *free_l = NULL;
+
+    for(i = 0; i < cpa_no_cached_labels; ++i)
+    {
+        if(cpa_label_cache[i].ct == ct && cpa_label_cache[i].phase == phase)
+        {
+            l = &(cpa_label_cache[i]);
+            break;
+        }
+        else if(cpa_label_cache[i].ct == NULL && free_l == NULL)
+        {
+            free_l = &(cpa_label_cache[i]);
+        }
+    }
+
+    if(l != NULL && (*l).no_int_cells == no_int_cells 
+        && (*l).connectivity == cpa_config.connectivity
+        && (*l).min_vol_frac == cpa_config.min_vol_frac)
+    {
+        return l;
+    }
+
+    if(l == NULL && free_l != NULL)
+    {
+        l = free_l;
+    }
+    else if(l == NULL)
+    {
+        if(cpa_no_cached_labels >= CPA_MAX_CACHED_LABELS)
+        {
+            Message("Error getCpaLabels(): Too many cell threads and phases (max. %i)!\n", 
+                        CPA_MAX_CACHED_LABELS);
+            return NULL;
+        }
+
+        l = &(cpa_label_cache[cpa_no_cached_labels]);
+        cpa_no_cached_labels ++;
+        (*l).label = NULL;
+        (*l).pending = NULL;
+        (*l).stack = NULL;
+        (*l).affected = NULL;
+        (*l).no_int_cells = -1;
+    }
+
+    if((*l).no_int_cells != no_int_cells)
+    {
+        freeCpaLabels(l);
+
+        (*l).label = (cell_t*) malloc((no_int_cells + 1) * sizeof(cell_t));
+        (*l).pending = (cell_t*) malloc((no_int_cells + 1) * sizeof(cell_t));
+        (*l).stack = (cell_t*) malloc((no_int_cells + 1) * sizeof(cell_t));
+        (*l).affected = (unsigned char*) calloc(no_int_cells + 1, sizeof(unsigned char));
+
+        if((*l).label == NULL || (*l).pending == NULL || (*l).stack == NULL 
+            || (*l).affected == NULL)
+        {
+            DebugMessage("Error (malloc): No free memory for cpa labels available!\n");
+            freeCpaLabels(l);
+            return NULL;    /* entry stays unused and is rebuilt next call */
+        }
+    }
+
+    resetIntArray((*l).label, no_int_cells, -1);
+
+    (*l).ct = ct;
+    (*l).phase = phase;
+    (*l).no_int_cells = no_int_cells;
+    (*l).connectivity = cpa_config.connectivity;
+    (*l).min_vol_frac = cpa_config.min_vol_frac;
+
+    return l;
+}
+
+
+int cpaIncremental(
+                Thread *ct,
+                Thread *ptp,
+                int phase,
+                struct CpaAdjacency *adj,
+                int *nb_offset,
+                cell_t *nbs,
+                struct CpaList *DList,
+                struct CpaArena *a
+                )
+{
+/*
+    Reuse the labels of the last call of ct and phase (see getCpaLabels()),
+    only new cells and the cells of marked cpas are flood filled, cpas are 
+    collected from the labels like from a disjoint set forest, so the results
+    are the same as with the other engines (O(cells), see above)
+*/
+    int state = STATE_OK;
+    cell_t c, ci, cx, r;
+    int i, cci;
+    int no_int_cells = THREAD_N_ELEMENTS_INT(ct);
+    int first_cpa = (*DList).no_cpas;
+    int no_pending = 0;
+    int no_new = 0;
+    int no_stack;
+    int any_affected = 0;
+    long no_lookups = 0;
+    double t_start;
+    real min_vol_frac = cpa_config.min_vol_frac;
+    struct CpaLabels *l = NULL;
+    cell_t *label;
+    int *root_cpa = NULL;
+    cell_t *root = NULL;
+
+    l = getCpaLabels(ct, phase);
+
+    if(l == NULL)
+    {
+        return STATE_ERROR;
+    }
+
+    label = (*l).label;
+
+    /* cells crossing the limit, mark the old cpas they touch */
+    for(c = 0; c < no_int_cells; ++c)
+    {
+        if(C_VOF(c, ptp) > min_vol_frac)
+        {
+            if(label[c] == -1)
+            {
+                (*l).pending[no_pending++] = c;
+                no_lookups += nb_offset[c+1] - nb_offset[c];
+
+                for(cci = nb_offset[c]; cci < nb_offset[c+1]; ++cci)
+                {
+                    ci = nbs[cci];
+
+                    if(ci < no_int_cells && label[ci] >= 0)
+                    {
+                        (*l).affected[label[ci]] = 1;
+                        any_affected = 1;
+                    }
+                }
+            }
+        }
+        else if(label[c] >= 0)
+        {
+            (*l).affected[label[c]] = 1;
+            any_affected = 1;
+        }
+    }
+
+    no_new = no_pending;
+
+    /* dissolve the marked cpas, their remaining cells are labelled again */
+    if(any_affected)
+    {
+        for(c = 0; c < no_int_cells; ++c)
+        {
+            if(label[c] >= 0 && (*l).affected[label[c]])
+            {
+                if(C_VOF(c, ptp) > min_vol_frac)
+                {
+                    label[c] = -2;
+                    (*l).pending[no_pending++] = c;
+                }
+                else
+                {
+                    label[c] = -1;
+                }
+            }
+        }
+
+        memset((*l).affected, 0, no_int_cells * sizeof(unsigned char));
+    }
+
+    for(i = 0; i < no_new; ++i)
+    {
+        label[(*l).pending[i]] = -2;
+    }
+
+    /* flood fill over the pending cells (-2), the seed is the root */
+    for(i = 0; i < no_pending; ++i)
+    {
+        r = (*l).pending[i];
+
+        if(label[r] != -2)
+        {
+            continue;
+        }
+
+        label[r] = r;
+        (*l).stack[0] = r;
+        no_stack = 1;
+
+        while(no_stack > 0)
+        {
+            cx = (*l).stack[--no_stack];
+            no_lookups += nb_offset[cx+1] - nb_offset[cx];
+
+            for(cci = nb_offset[cx]; cci < nb_offset[cx+1]; ++cci)
+            {
+                ci = nbs[cci];
+
+                if(ci < no_int_cells && label[ci] == -2)
+                {
+                    label[ci] = r;
+                    (*l).stack[no_stack++] = ci;
+                }
+            }
+        }
+    }
+
+    cpa_timings.no_nb_lookups += no_lookups;
+
+    root_cpa = (int*) malloc((no_int_cells + 1) * sizeof(int));
+    root = (cell_t*) malloc((no_int_cells + 1) * sizeof(cell_t));
+
+    if(root_cpa == NULL || root == NULL)
+    {
+        DebugMessage("Error (malloc): No free memory for cpa collection available!\n");
+        state = STATE_ERROR;
+    }
+
+    if(state == STATE_OK)
+    {
+        state = cpaListsFromForest(label, no_int_cells, 
+                        (CPA_MAX_THREADS > 1 && no_int_cells >= CPA_OMP_MIN_CELLS),
+                        root, root_cpa, DList, a);
+    }
+
+    if(root_cpa != NULL) free(root_cpa);
+    if(root != NULL) free(root);
+
+    if(state != STATE_OK)
+    {
+        freeCpaLabels(l);   /* labels may be incomplete, full labelling next call */
+        return state;
+    }
+
+    t_start = cpaWallTime();
+    state = cpaReduceCpas(ct, ptp, adj, DList, first_cpa, a);
+    cpa_timings.reduction += cpaWallTime() - t_start;
+
+    return state;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/*
+Global cpas: a cpa split by partition boundaries is found as one fragment per
+compute node. Every compute node packs its cpas (sums and boundary lists) 
+together with their partition boundary cells and the exterior cells connected
+to them (global cell ids, see updateCpaParCells()) and sends them to node 0. 
+There the exterior cells are looked up in the partition boundary cells of all
+fragments, so a fragment is merged with the fragment owning the exterior cell
+(union find over all fragments). The merged cpas get globally unique ids (numbered by compute 
+node and local index of their first fragment), which are sent back, so every 
+local cpa knows the global cpa it belongs to.
+
+The union find runs serially on node 0 instead of being distributed over the
+compute nodes: it only works on fragments, not on cells, so it is short and
+exact for face, edge and vertex connectivity without extra communication
+rounds between neighboring partitions. Node 0 holds all fragments at once, per
+fragment CPA_FRAG_INTS ints and CPA_FRAG_REALS reals plus its boundary ids,
+partition boundary cells and exterior cells, i.e. memory grows with the total
+number of fragments and the cpa cells at partition boundaries, not with the
+number of cells of the mesh.
+*/
+
+#define CPA_FRAG_INTS 4             /* no_cells, no_boundaries, no_par_cells, no_par_ext_cells */
+#define CPA_FRAG_REALS (4 + ND_ND)  /* mass, vol, alpha sum, alpha max, com weights */
+
+struct CpaFragments     /* Packed cpas of one compute node */
+{
+    int no_cpas;
+    int no_ints;
+    int no_reals;
+    int *ints;          /* CPA_FRAG_INTS per cpa, then boundary ids, par and ext cells per cpa */
+    real *reals;        /* CPA_FRAG_REALS per cpa */
+};
+
+
+void initCpaFragments(struct CpaFragments *fr)
+{
+    (*fr).no_cpas = 0;
+    (*fr).no_ints = 0;
+    (*fr).no_reals = 0;
+    (*fr).ints = NULL;
+    (*fr).reals = NULL;
+}
+
+
+int allocCpaFragments(struct CpaFragments *fr, struct CpaArena *a)
+{
+    (*fr).ints = (int*) cpaArenaAlloc(a, ((*fr).no_ints + 1) * sizeof(int));
+    (*fr).reals = (real*) cpaArenaAlloc(a, ((*fr).no_reals + 1) * sizeof(real));
+
+    if((*fr).ints == NULL || (*fr).reals == NULL)
+    {
+        DebugMessage("Error (arena): No free memory for cpa fragments available!\n");
+        initCpaFragments(fr);
+        return STATE_ERROR;
+    }
+
+    return STATE_OK;
+}
+
+
+int cpaPackFragments(struct CpaList *DList, struct CpaFragments *fr, struct CpaArena *a)
+{
+    int k, j;
+    int no_list_ints = 0;
+    int *p = NULL;
+    real *r = NULL;
+    struct Cpa *D = NULL;
+
+    initCpaFragments(fr);
+
+    for(k = 0; k < (*DList).no_cpas; ++k)
+    {
+        D = &((*DList).cpas[k]);
+        no_list_ints += (*D).no_boundaries + (*D).no_par_cells + (*D).no_par_ext_cells;
+    }
+
+    (*fr).no_cpas = (*DList).no_cpas;
+    (*fr).no_ints = CPA_FRAG_INTS * (*fr).no_cpas + no_list_ints;
+    (*fr).no_reals = CPA_FRAG_REALS * (*fr).no_cpas;
+
+    if(allocCpaFragments(fr, a) != STATE_OK)
+    {
+        return STATE_ERROR;
+    }
+
+    p = (*fr).ints + CPA_FRAG_INTS * (*fr).no_cpas;
+
+    for(k = 0; k < (*fr).no_cpas; ++k)
+    {
+        D = &((*DList).cpas[k]);
+
+        (*fr).ints[CPA_FRAG_INTS*k] = (*D).no_cells;
+        (*fr).ints[CPA_FRAG_INTS*k + 1] = (*D).no_boundaries;
+        (*fr).ints[CPA_FRAG_INTS*k + 2] = (*D).no_par_cells;
+        (*fr).ints[CPA_FRAG_INTS*k + 3] = (*D).no_par_ext_cells;
+
+        r = (*fr).reals + CPA_FRAG_REALS*k;
+        r[0] = (*D).mass;
+        r[1] = (*D).vol;
+        r[2] = (*D).alpha_mean * (*D).no_cells;    /* sum, see finalizeCpa() */
+        r[3] = (*D).alpha_max;
+
+        for(j = 0; j < ND_ND; ++j)
+        {
+            r[4 + j] = (*D).sumed_com_cell_weights[j];
+        }
+
+        for(j = 0; j < (*D).no_boundaries; ++j)
+        {
+            *(p++) = (*D).boundary_id[j];
+        }
+
+        for(j = 0; j < (*D).no_par_cells; ++j)
+        {
+            *(p++) = (*D).par_cells[j];
+        }
+
+        for(j = 0; j < (*D).no_par_ext_cells; ++j)
+        {
+            *(p++) = (*D).par_ext_cells[j];
+        }
+    }
+
+    return STATE_OK;
+}
+
+
+int cpaStitchFragments(
+                        struct CpaFragments *fr,
+                        int no_ranks,
+                        struct CpaList *GList,
+                        int *global_ids,
+                        struct CpaArena *a
+                        )
+{
+/*
+    Merge the fragments of all compute nodes (fr[rank]) to global cpas in 
+    GList. global_ids gets the global id of every fragment (fragments are 
+    ordered by rank and local cpa index).
+*/
+    int state = STATE_OK;
+    int i, j, k, g, nb, np, ne;
+    int no_frags = 0;
+    int no_owners = 0;
+    int *owners = NULL;                     /*(partition boundary cell, fragment)*/
+    int *owner = NULL;
+    int *root_gid = NULL;                   /*global id of root fragments*/
+    cell_t *parent = NULL;
+    unsigned char *rank = NULL;
+    int *p = NULL;
+    real *r = NULL;
+    struct Cpa *D = NULL;
+
+    for(i = 0; i < no_ranks; ++i)
+    {
+        no_frags += fr[i].no_cpas;
+
+        for(k = 0; k < fr[i].no_cpas; ++k)
+        {
+            no_owners += fr[i].ints[CPA_FRAG_INTS*k + 2];
+        }
+    }
+
+    owners = (int*) malloc((2 * no_owners + 2) * sizeof(int));
+    root_gid = (int*) malloc((no_frags + 1) * sizeof(int));
+    parent = (cell_t*) malloc((no_frags + 1) * sizeof(cell_t));
+    rank = (unsigned char*) calloc(no_frags + 1, sizeof(unsigned char));
+
+    if(owners == NULL || root_gid == NULL || parent == NULL || rank == NULL)
+    {
+        DebugMessage("Error (malloc): No free memory for cpa stitching available!\n");
+        state = STATE_ERROR;
+    }
+
+    /* owning fragment of every partition boundary cell */
+    if(state == STATE_OK)
+    {
+        g = 0;
+        no_owners = 0;
+
+        for(i = 0; i < no_ranks; ++i)
+        {
+            p = fr[i].ints + CPA_FRAG_INTS * fr[i].no_cpas;
+
+            for(k = 0; k < fr[i].no_cpas; ++k)
+            {
+                nb = fr[i].ints[CPA_FRAG_INTS*k + 1];
+                np = fr[i].ints[CPA_FRAG_INTS*k + 2];
+                ne = fr[i].ints[CPA_FRAG_INTS*k + 3];
+                p += nb;
+
+                for(j = 0; j < np; ++j)
+                {
+                    owners[2*no_owners] = p[j];
+                    owners[2*no_owners + 1] = g;
+                    no_owners ++;
+                }
+
+                p += np + ne;
+                parent[g] = g;
+                root_gid[g] = -1;
+                g ++;
+            }
+        }
+
+        if(no_owners > 1)
+        {
+            qsort(owners, no_owners, 2 * sizeof(int), compareIntPair);
+        }
+    }
+
+    /* a fragment connected to an exterior cell belongs to the same cpa as 
+       the fragment owning the cell */
+    if(state == STATE_OK && no_owners > 0)
+    {
+        g = 0;
+
+        for(i = 0; i < no_ranks; ++i)
+        {
+            p = fr[i].ints + CPA_FRAG_INTS * fr[i].no_cpas;
+
+            for(k = 0; k < fr[i].no_cpas; ++k)
+            {
+                nb = fr[i].ints[CPA_FRAG_INTS*k + 1];
+                np = fr[i].ints[CPA_FRAG_INTS*k + 2];
+                ne = fr[i].ints[CPA_FRAG_INTS*k + 3];
+                p += nb + np;
+
+                for(j = 0; j < ne; ++j)
+                {
+                    owner = (int*) bsearch(&(p[j]), owners, no_owners, 2 * sizeof(int), 
+                                            compareInt);
+
+                    if(owner != NULL)
+                    {
+                        cpaUnion(parent, rank, g, owner[1]);
+                    }
+                }
+
+                p += ne;
+                g ++;
+            }
+        }
+    }
+
+    /* number global cpas by their first fragment, sum up all fragments */
+    if(state == STATE_OK)
+    {
+        g = 0;
+
+        for(i = 0; i < no_ranks && state == STATE_OK; ++i)
+        {
+            p = fr[i].ints + CPA_FRAG_INTS * fr[i].no_cpas;
+
+            for(k = 0; k < fr[i].no_cpas; ++k)
+            {
+                j = cpaFindRoot(parent, g);
+
+                if(root_gid[j] == -1)
+                {
+                    D = cpaListNew(GList, a);
+
+                    if(D == NULL)
+                    {
+                        state = STATE_ERROR;
+                        break;
+                    }
+
+                    resetCpa(D);
+                    (*D).no_fragments = 0;
+                    (*D).global_id = (*GList).no_cpas - 1;
+                    root_gid[j] = (*D).global_id;
+                }
+
+                global_ids[g] = root_gid[j];
+                D = &((*GList).cpas[root_gid[j]]);
+                r = fr[i].reals + CPA_FRAG_REALS*k;
+
+                (*D).no_cells += fr[i].ints[CPA_FRAG_INTS*k];
+                (*D).mass += r[0];
+                (*D).vol += r[1];
+                (*D).alpha_mean += r[2];
+
+                if((*D).alpha_max < r[3])
+                {
+                    (*D).alpha_max = r[3];
+                }
+
+                for(j = 0; j < ND_ND; ++j)
+                {
+                    (*D).sumed_com_cell_weights[j] += r[4 + j];
+                }
+
+                nb = fr[i].ints[CPA_FRAG_INTS*k + 1];
+                np = fr[i].ints[CPA_FRAG_INTS*k + 2];
+                ne = fr[i].ints[CPA_FRAG_INTS*k + 3];
+
+                for(j = 0; j < nb; ++j)
+                {
+                    updateCpaBoundaryID_List(D, p[j], a);
+                }
+
+                p += nb + np + ne;
+                (*D).no_fragments ++;
+                g ++;
+            }
+        }
+    }
+
+    if(state == STATE_OK)
+    {
+        for(k = 0; k < (*GList).no_cpas; ++k)
+        {
+            finalizeCpa(&((*GList).cpas[k]));
+        }
+    }
+
+    if(owners != NULL) free(owners);
+    if(root_gid != NULL) free(root_gid);
+    if(parent != NULL) free(parent);
+    if(rank != NULL) free(rank);
+
+    return state;
+}
+
+
+int cpaGlobalCpas(
+                    char filename[], 
+                    struct CpaList *DList, 
+                    struct CpaList *GList, 
+                    struct CpaArena *a
+                    )
+{
+/*
+    Stitch the cpas of all compute nodes (collective, has to be called on 
+    every compute node), set the global ids of the cpas in DList and write 
+    the global cpas on node 0 to filename. The global cpas are appended to 
+    GList on node 0 (GList stays empty on the other compute nodes)
+*/
+    int state = STATE_OK;
+    int i, k;
+    int no_ranks = 1;
+    int me = 0;                             /*rank, myid is node_serial in serial*/
+    int no_frags = 0;
+    int offset = 0;
+    int *global_ids = NULL;
+    real vol_total = 0.0;
+    real vol_max = 0.0;
+    struct CpaFragments own;
+    struct CpaFragments *fr = NULL;
+    int go = 1;                             /*node 0 stores all fragments*/
+    #if RP_NODE
+    int header[3];
+    #endif
+
+    state = cpaPackFragments(DList, &own, a);
+
+    #if RP_NODE
+    no_ranks = compute_node_count;
+    me = myid;
+
+    if(!I_AM_NODE_ZERO_P)
+    {
+        global_ids = (int*) cpaArenaAlloc(a, (own.no_cpas + 1) * sizeof(int));
+
+        if(global_ids == NULL)
+        {
+            initCpaFragments(&own);
+            state = STATE_ERROR;
+        }
+
+        header[0] = own.no_cpas;
+        header[1] = own.no_ints;
+        header[2] = own.no_reals;
+
+        PRF_CSEND_INT(node_zero, header, 3, myid);
+
+        /* the fragments are only sent if node 0 can store all of them */
+        PRF_CRECV_INT(node_zero, &go, 1, node_zero);
+
+        if(go && own.no_cpas > 0)
+        {
+            PRF_CSEND_INT(node_zero, own.ints, own.no_ints, myid);
+            PRF_CSEND_REAL(node_zero, own.reals, own.no_reals, myid);
+            PRF_CRECV_INT(node_zero, global_ids, own.no_cpas, node_zero);
+
+            for(k = 0; k < own.no_cpas; ++k)
+            {
+                (*DList).cpas[k].global_id = global_ids[k];
+            }
+        }
+        else if(!go)
+        {
+            state = STATE_ERROR;
+        }
+
+        return state;
+    }
+    #endif
+
+    /* node 0: collect the fragment sizes of all compute nodes, on memory 
+       errors the headers are still received and every compute node is told 
+       not to send its fragments, so no compute node is left waiting */
+    fr = (struct CpaFragments*) cpaArenaAlloc(a, no_ranks * sizeof(struct CpaFragments));
+
+    if(fr == NULL)
+    {
+        DebugMessage("Error (arena): No free memory for cpa fragments available!\n");
+        go = 0;
+    }
+
+    for(i = 0; i < no_ranks && fr != NULL; ++i)
+    {
+        initCpaFragments(&(fr[i]));
+    }
+
+    if(fr != NULL)
+    {
+        fr[me] = own;
+        no_frags = own.no_cpas;
+    }
+
+    #if RP_NODE
+    compute_node_loop_not_zero(i)
+    {
+        PRF_CRECV_INT(i, header, 3, i);
+
+        if(go && header[0] > 0)
+        {
+            fr[i].no_cpas = header[0];
+            fr[i].no_ints = header[1];
+            fr[i].no_reals = header[2];
+            no_frags += header[0];
+
+            if(allocCpaFragments(&(fr[i]), a) != STATE_OK)
+            {
+                go = 0;
+            }
+        }
+    }
+    #endif
+
+    if(go)
+    {
+        global_ids = (int*) cpaArenaAlloc(a, (no_frags + 1) * sizeof(int));
+
+        if(global_ids == NULL)
+        {
+            DebugMessage("Error (arena): No free memory for global cpa ids available!\n");
+            go = 0;
+        }
+    }
+
+    #if RP_NODE
+    compute_node_loop_not_zero(i)
+    {
+        PRF_CSEND_INT(i, &go, 1, myid);
+    }
+
+    compute_node_loop_not_zero(i)
+    {
+        if(go && fr[i].no_cpas > 0)
+        {
+            PRF_CRECV_INT(i, fr[i].ints, fr[i].no_ints, i);
+            PRF_CRECV_REAL(i, fr[i].reals, fr[i].no_reals, i);
+        }
+    }
+    #endif
+
+    if(!go)
+    {
+        (*GList).no_cpas = 0;
+        return STATE_ERROR;
+    }
+
+    for(k = 0; k < no_frags; ++k)
+    {
+        global_ids[k] = -1;
+    }
+
+    if(state == STATE_OK)
+    {
+        state = cpaStitchFragments(fr, no_ranks, GList, global_ids, a);
+    }
+
+    /* hand back the global ids (-1 on error) */
+    for(i = 0; i < no_ranks; ++i)
+    {
+        if(i == me)
+        {
+            for(k = 0; k < fr[i].no_cpas; ++k)
+            {
+                (*DList).cpas[k].global_id = global_ids[offset + k];
+            }
+        }
+        #if RP_NODE
+        else if(fr[i].no_cpas > 0)
+        {
+            PRF_CSEND_INT(i, global_ids + offset, fr[i].no_cpas, myid);
+        }
+        #endif
+
+        offset += fr[i].no_cpas;
+    }
+
+    if(state == STATE_OK)
+    {
+        for(k = 0; k < (*GList).no_cpas; ++k)
+        {
+            vol_total += (*GList).cpas[k].vol;
+
+            if(vol_max < (*GList).cpas[k].vol)
+            {
+                vol_max = (*GList).cpas[k].vol;
+            }
+        }
+
+        Message("Found %i global cpas (%i fragments), total volume %lE m³, "
+                "largest cpa %lE m³.\n", (*GList).no_cpas, no_frags, vol_total, vol_max);
+
+        #if _OUTPUT == CPA_OUTPUT_BINARY
+        state = writeCpasBinary(filename, -1, (*GList).cpas, (*GList).no_cpas);
+        #else
+        state = printGlobalCpas(filename, (*GList).cpas, (*GList).no_cpas);
+        #endif
+    }
+    else
+    {
+        (*GList).no_cpas = 0;   /* no tracking of incomplete cpas */
+    }
+
+    return state;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/*
+Tracking: the global cpas of consecutive detection calls are linked by their 
+cell overlap. Every compute node keeps the track id of each of its cells from
+the last call and counts the cells every local cpa shares with each previous 
+track (overlap triples: global id, track id, cells), node 0 sums them up over
+all fragments. A cpa continues the track it shares most cells with (greedy, 
+largest overlap first). Cpas without any overlap (small fast droplets) are 
+matched with the previous cpas without successor by center of mass distance 
+(below CPA_TRACK_SEARCH_RADIUS times the edge of the volume equivalent cube 
+of the previous cpa, volume ratio below CPA_TRACK_MAX_VOL_RATIO) in the 
+neighboring buckets of a spatial hash, all other cpas start new tracks.
+A track overlapping several cpas is a breakup, a cpa overlapping several 
+tracks a coalescence, both are appended with the track ids of the parents and
+children to cpa_events.txt. The track id of every global cpa is appended to
+cpa_tracks.txt (one block per call).
+*/
+
+struct CpaTrackZone     /* Track ids of the cells of one fluid zone (last call) */
+{
+    Thread  *ct;
+    int     no_int_cells;
+    int     *track;                     /* -1: no cpa cell */
+};
+
+struct CpaTracker       /* Persistent ids of the global cpas of one phase and limit */
+{
+    int     in_use;
+    int     phase;
+    real    limit;
+    int     next_id;
+    struct CpaTrackZone zones[CPA_MAX_ZONES];
+    int     no_prev;                    /* global cpas of the last call (node 0) */
+    int     *prev_track;                /* sorted by track id */
+    real    *prev_com;                  /* ND_ND per cpa */
+    real    *prev_vol;
+};
+
+static struct CpaTracker cpa_trackers[CPA_MAX_DETECT_PHASES * CPA_MAX_THRESHOLDS];
+
+
+void freeCpaTrackZones(struct CpaTracker *tr)
+{
+    int i;
+
+    for(i = 0; i < CPA_MAX_ZONES; ++i)
+    {
+        if((*tr).zones[i].track != NULL) free((*tr).zones[i].track);
+
+        (*tr).zones[i].track = NULL;
+        (*tr).zones[i].ct = NULL;
+        (*tr).zones[i].no_int_cells = -1;
+    }
+}
+
+
+void freeCpaTracker(struct CpaTracker *tr)
+{
+    freeCpaTrackZones(tr);
+
+    if((*tr).prev_track != NULL) free((*tr).prev_track);
+    if((*tr).prev_com != NULL) free((*tr).prev_com);
+    if((*tr).prev_vol != NULL) free((*tr).prev_vol);
+
+    (*tr).prev_track = NULL;
+    (*tr).prev_com = NULL;
+    (*tr).prev_vol = NULL;
+    (*tr).no_prev = 0;
+    (*tr).next_id = 0;
+    (*tr).in_use = 0;
+}
+
+
+void resetCpaTrackers(int keep_ids)
+{
+/*
+    Forget the cell overlaps of all trackers (mesh changed), with keep_ids 
+    == 0 also the tracks (new case)
+*/
+    int i;
+
+    for(i = 0; i < CPA_MAX_DETECT_PHASES * CPA_MAX_THRESHOLDS; ++i)
+    {
+        if(keep_ids)
+        {
+            freeCpaTrackZones(&(cpa_trackers[i]));
+        }
+        else
+        {
+            freeCpaTracker(&(cpa_trackers[i]));
+        }
+    }
+}
+
+
+struct CpaTracker *getCpaTracker(int ip, int k, int phase, real limit)
+{
+/*
+    Tracker of the ip-th detected phase and the k-th limit, the tracks 
+    start again if the phase or the limit have been changed
+*/
+    struct CpaTracker *tr = &(cpa_trackers[ip * CPA_MAX_THRESHOLDS + k]);
+
+    if((*tr).in_use && ((*tr).phase != phase || (*tr).limit != limit))
+    {
+        freeCpaTracker(tr);
+    }
+
+    if(!(*tr).in_use)
+    {
+        (*tr).in_use = 1;
+        (*tr).phase = phase;
+        (*tr).limit = limit;
+        (*tr).next_id = 0;
+    }
+
+    return tr;
+}
+
+
+int cpaTrackZoneCells(struct CpaTracker *tr, int zone, Thread *ct)
+{
+/*
+    Make sure the track ids of the cells of zone belong to cell thread ct,
+    they are reset to -1 (no overlap) if the zone or its cells changed
+*/
+    struct CpaTrackZone *z = &((*tr).zones[zone]);
+    int no_int_cells = THREAD_N_ELEMENTS_INT(ct);
+
+    if((*z).ct == ct && (*z).no_int_cells == no_int_cells && (*z).track != NULL)
+    {
+        return STATE_OK;
+    }
+
+    if((*z).track != NULL) free((*z).track);
+
+    (*z).ct = NULL;
+    (*z).no_int_cells = -1;
+    (*z).track = (int*) malloc((no_int_cells + 1) * sizeof(int));
+
+    if((*z).track == NULL)
+    {
+        DebugMessage("Error (malloc): No free memory for cell track ids available!\n");
+        return STATE_ERROR;
+    }
+
+    resetIntArray((*z).track, no_int_cells, -1);
+    (*z).ct = ct;
+    (*z).no_int_cells = no_int_cells;
+
+    return STATE_OK;
+}
+
+
+int compareIntTriple(const void *a, const void *b)	/* lexicographic, int[3] */
+{
+    const int *ia = (const int*) a;
+    const int *ib = (const int*) b;
+
+    if(ia[0] != ib[0])
+    {
+        return (ia[0] > ib[0]) - (ia[0] < ib[0]);
+    }
+
+    if(ia[1] != ib[1])
+    {
+        return (ia[1] > ib[1]) - (ia[1] < ib[1]);
+    }
+
+    return (ia[2] > ib[2]) - (ia[2] < ib[2]);
+}
+
+
+int cpaTrackOverlaps(
+                    struct CpaTracker *tr,
+                    struct CpaList *DList,
+                    int **ov,
+                    int *no_ov,
+                    struct CpaArena *a
+                    )
+{
+/*
+    Overlap triples (global id, track id, number of cells) of the local cpas
+    of DList with the tracks of the last call. The cell lists are sorted by 
+    cell index, neighboring cells mostly share the track, so runs of equal 
+    track ids are counted at once
+*/
+    int state = STATE_OK;
+    int k, dci, t, last, cnt;
+    int len = 0;
+    int capacity = 0;
+    int *track;
+    struct Cpa *D = NULL;
+
+    *ov = NULL;
+
+    for(k = 0; k < (*DList).no_cpas && state == STATE_OK; ++k)
+    {
+        D = &((*DList).cpas[k]);
+        track = (*tr).zones[(*D).zone].track;
+
+        if(track == NULL || (*D).global_id < 0 || (*D).cell_list == NULL)
+        {
+            continue;
+        }
+
+        last = -1;
+        cnt = 0;
+
+        for(dci = 0; dci <= (*D).no_cells && state == STATE_OK; ++dci)
+        {
+            t = (dci < (*D).no_cells) ? track[(*D).cell_list[dci]] : -1;
+
+            if(t != last)
+            {
+                if(last >= 0)
+                {
+                    state = cpaIntListAppend(ov, &len, &capacity, (*D).global_id, a);
+                    if(state == STATE_OK) state = cpaIntListAppend(ov, &len, &capacity, last, a);
+                    if(state == STATE_OK) state = cpaIntListAppend(ov, &len, &capacity, cnt, a);
+                }
+
+                last = t;
+                cnt = 0;
+            }
+
+            cnt ++;
+        }
+    }
+
+    *no_ov = len / 3;
+
+    return state;
+}
+
+
+int cpaPrevTrackIndex(struct CpaTracker *tr, int t)	/* -1: not a track of the last call */
+{
+    int *p = NULL;
+
+    if((*tr).no_prev > 0)
+    {
+        p = (int*) bsearch(&t, (*tr).prev_track, (*tr).no_prev, sizeof(int), compareInt);
+    }
+
+    return (p != NULL) ? (int) (p - (*tr).prev_track) : -1;
+}
+
+
+int cpaTrackBucket(real x[ND_ND], real h, int *offset)	/* spatial hash key */
+{
+    unsigned int key = 0;
+    int j;
+
+    for(j = 0; j < ND_ND; ++j)
+    {
+        key = key * 73856093u ^ (unsigned int) ((int) floor(x[j] / h) + offset[j]);
+    }
+
+    return (int) (key & 0x7fffffff);
+}
+
+
+int cpaMatchByDistance(
+                        struct CpaTracker *tr,
+                        struct CpaList *GList,
+                        int *track_ids,
+                        int *g_parents,
+                        unsigned char *prev_done,
+                        struct CpaArena *a
+                        )
+{
+/*
+    Match the global cpas without overlap with the previous cpas without 
+    successor (prev_done == 0) by center of mass distance, returns the 
+    number of matches
+*/
+    int g, p, i, j, q, best;
+    int no_cand = 0;
+    int no_matches = 0;
+    int offset[ND_ND];
+    int key[2];
+    int *buckets = NULL;                    /*(key, previous cpa)*/
+    int *hit = NULL;
+    real h = 0.0;
+    real radius, dist, best_dist, ratio;
+    real *radii = NULL;
+    real *x = NULL;
+    struct Cpa *D = NULL;
+
+    radii = (real*) cpaArenaAlloc(a, ((*tr).no_prev + 1) * sizeof(real));
+    buckets = (int*) cpaArenaAlloc(a, (2 * (*tr).no_prev + 2) * sizeof(int));
+
+    if(radii == NULL || buckets == NULL)
+    {
+        DebugMessage("Error (arena): No free memory for track matching available!\n");
+        return 0;
+    }
+
+    for(p = 0; p < (*tr).no_prev; ++p)
+    {
+        radii[p] = CPA_TRACK_SEARCH_RADIUS * pow((*tr).prev_vol[p], 1.0/ND_ND);
+
+        if(!prev_done[p] && radii[p] > h)
+        {
+            h = radii[p];
+        }
+    }
+
+    if(!(h > 0.0))
+    {
+        return 0;
+    }
+
+    /* previous cpas by bucket of edge h (covers every search radius) */
+    for(j = 0; j < ND_ND; ++j)
+    {
+        offset[j] = 0;
+    }
+
+    for(p = 0; p < (*tr).no_prev; ++p)
+    {
+        if(!prev_done[p])
+        {
+            buckets[2*no_cand] = cpaTrackBucket(&((*tr).prev_com[ND_ND*p]), h, offset);
+            buckets[2*no_cand + 1] = p;
+            no_cand ++;
+        }
+    }
+
+    qsort(buckets, no_cand, 2 * sizeof(int), compareIntPair);
+
+    for(g = 0; g < (*GList).no_cpas; ++g)
+    {
+        if(track_ids[g] != -1 || g_parents[g] > 0)
+        {
+            continue;
+        }
+
+        D = &((*GList).cpas[g]);
+        best = -1;
+        best_dist = 0.0;
+
+        for(i = 0; i < (int) pow(3, ND_ND); ++i)   /* own and neighboring buckets */
+        {
+            for(j = 0, q = i; j < ND_ND; ++j, q /= 3)
+            {
+                offset[j] = q % 3 - 1;
+            }
+
+            key[0] = cpaTrackBucket((*D).com, h, offset);
+            key[1] = -1;
+
+            /* first entry of the bucket */
+            hit = buckets;
+            q = no_cand;
+
+            while(q > 0)
+            {
+                if(compareIntPair(hit + 2*(q/2), key) < 0)
+                {
+                    hit += 2*(q/2 + 1);
+                    q -= q/2 + 1;
+                }
+                else
+                {
+                    q /= 2;
+                }
+            }
+
+            for(; hit < buckets + 2*no_cand && hit[0] == key[0]; hit += 2)
+            {
+                p = hit[1];
+
+                if(prev_done[p])
+                {
+                    continue;
+                }
+
+                x = &((*tr).prev_com[ND_ND*p]);
+                dist = 0.0;
+
+                for(j = 0; j < ND_ND; ++j)
+                {
+                    dist += ((*D).com[j] - x[j]) * ((*D).com[j] - x[j]);
+                }
+
+                dist = sqrt(dist);
+                radius = radii[p];
+                ratio = (*D).vol / (*tr).prev_vol[p];
+
+                if(dist < radius && ratio < CPA_TRACK_MAX_VOL_RATIO 
+                    && ratio > 1.0/CPA_TRACK_MAX_VOL_RATIO
+                    && (best == -1 || dist < best_dist))
+                {
+                    best = p;
+                    best_dist = dist;
+                }
+            }
+        }
+
+        if(best != -1)
+        {
+            track_ids[g] = (*tr).prev_track[best];
+            prev_done[best] = 1;
+            no_matches ++;
+        }
+    }
+
+    return no_matches;
+}
+
+
+int writeCpaEvents(
+                    char filename[],
+                    char event[],
+                    int *ov,
+                    int no_ov,
+                    int *ids,
+                    int *no_related
+                    )
+{
+/*
+    Append one line per group of the sorted overlap triples ov with 
+    no_related[group] > 1: time, event, ids[group], [related track ids]. 
+    ov[3*i] is the group, ov[3*i+1] the related track id
+*/
+    FILE *fd = NULL;
+    int i, j;
+    int new_file = !cfileexists(filename);
+
+    for(i = 0; i < no_ov; i = j)
+    {
+        j = i + 1;
+
+        while(j < no_ov && ov[3*j] == ov[3*i])
+        {
+            j ++;
+        }
+
+        if(no_related[ov[3*i]] < 2)
+        {
+            continue;
+        }
+
+        if(fd == NULL)
+        {
+            fd = fopen(filename, "a");
+
+            if(fd == NULL)
+            {
+                Message("Error (writeCpaEvents()): Unable to open file %s "
+                        "for writing!\n", filename);
+                return STATE_ERROR;
+            }
+
+            if(new_file)
+            {
+                fprintf(fd, "time,event,track_id,[related_track_ids]\n");
+            }
+        }
+
+        fprintf(fd, "%lf,%s,%i,[", CURRENT_TIME, event, ids[ov[3*i]]);
+
+        for(; i < j; ++i)
+        {
+            fprintf(fd, (i < j - 1) ? "%i," : "%i", ov[3*i + 1]);
+        }
+
+        fprintf(fd, "]\n");
+    }
+
+    if(fd != NULL)
+    {
+        fclose(fd);
+    }
+
+    return STATE_OK;
+}
+
+
+int printCpaTracks(char filename[], int *track_ids, int sizeGList)
+{
+    FILE *fd = NULL;
+    int i;
+
+    fd = fopen(filename, "a");
+
+    if(fd == NULL)
+    {
+        Message("Error (printCpaTracks()): Unable to open file %s "
+                "for writing!\n", filename);
+        return STATE_ERROR;
+    }
+
+    fprintf(fd, "{\n");
+    fprintf(fd, "%lf\n", CURRENT_TIME);
+    fprintf(fd, "global_id,track_id\n");
+
+    for(i = 0; i < sizeGList; ++i)
+    {
+        fprintf(fd, "%i,%i\n", i, track_ids[i]);
+    }
+
+    fprintf(fd, "}\n");
+    fclose(fd);
+
+    return STATE_OK;
+}
+
+
+int cpaMatchTracks(
+                    char suffix[],
+                    struct CpaTracker *tr,
+                    int *ov,
+                    int no_ov,
+                    struct CpaList *GList,
+                    int *track_ids,
+                    struct CpaArena *a
+                    )
+{
+/*
+    Node 0: assign track ids to the global cpas of GList from the overlap 
+    triples ov of all compute nodes, write events and tracks and keep the 
+    cpas as previous cpas of the next call
+*/
+    int state = STATE_OK;
+    int i, j, g, p;
+    int n = (*GList).no_cpas;
+    int no_continued = 0;
+    int no_matched = 0;
+    int no_new = 0;
+    int *g_parents = NULL;                  /*overlapping tracks per cpa*/
+    int *p_children = NULL;                 /*overlapping cpas per track*/
+    int *p_ids = NULL;
+    int *order = NULL;
+    unsigned char *prev_done = NULL;
+    char filename[100];
+
+    g_parents = (int*) cpaArenaAlloc(a, (n + 1) * sizeof(int));
+    p_children = (int*) cpaArenaAlloc(a, ((*tr).no_prev + 1) * sizeof(int));
+    p_ids = (int*) cpaArenaAlloc(a, ((*tr).no_prev + 1) * sizeof(int));
+    order = (int*) cpaArenaAlloc(a, (3 * no_ov + 3) * sizeof(int));
+    prev_done = (unsigned char*) cpaArenaAlloc(a, (*tr).no_prev + 1);
+
+    if(g_parents == NULL || p_children == NULL || p_ids == NULL || order == NULL 
+        || prev_done == NULL)
+    {
+        DebugMessage("Error (arena): No free memory for track matching available!\n");
+        return STATE_ERROR;
+    }
+
+    resetIntArray(g_parents, n, 0);
+    resetIntArray(p_children, (*tr).no_prev, 0);
+    memset(prev_done, 0, (*tr).no_prev);
+
+    for(p = 0; p < (*tr).no_prev; ++p)
+    {
+        p_ids[p] = (*tr).prev_track[p];
+    }
+
+    /* sum up the fragments, drop unknown tracks (replace track by index) */
+    if(no_ov > 1)
+    {
+        qsort(ov, no_ov, 3 * sizeof(int), compareIntTriple);
+    }
+
+    for(i = 0, j = 0; i < no_ov; ++i)
+    {
+        p = cpaPrevTrackIndex(tr, ov[3*i + 1]);
+
+        if(ov[3*i] < 0 || ov[3*i] >= n || p == -1)
+        {
+            continue;
+        }
+
+        if(j > 0 && ov[3*(j-1)] == ov[3*i] && ov[3*(j-1) + 1] == p)
+        {
+            ov[3*(j-1) + 2] += ov[3*i + 2];
+            continue;
+        }
+
+        ov[3*j] = ov[3*i];
+        ov[3*j + 1] = p;
+        ov[3*j + 2] = ov[3*i + 2];
+        g_parents[ov[3*j]] ++;
+        p_children[p] ++;
+        j ++;
+    }
+
+    no_ov = j;
+
+    /* largest overlap first: (-cells, cpa, track) */
+    for(i = 0; i < no_ov; ++i)
+    {
+        order[3*i] = -ov[3*i + 2];
+        order[3*i + 1] = ov[3*i];
+        order[3*i + 2] = ov[3*i + 1];
+    }
+
+    if(no_ov > 1)
+    {
+        qsort(order, no_ov, 3 * sizeof(int), compareIntTriple);
+    }
+
+    for(i = 0; i < no_ov; ++i)
+    {
+        g = order[3*i + 1];
+        p = order[3*i + 2];
+
+        if(track_ids[g] == -1 && !prev_done[p])
+        {
+            track_ids[g] = (*tr).prev_track[p];
+            prev_done[p] = 1;
+            no_continued ++;
+        }
+    }
+
+    for(p = 0; p < (*tr).no_prev; ++p)
+    {
+        prev_done[p] = (prev_done[p] || p_children[p] > 0);
+    }
+
+    no_matched = cpaMatchByDistance(tr, GList, track_ids, g_parents, prev_done, a);
+
+    for(g = 0; g < n; ++g)
+    {
+        if(track_ids[g] == -1)
+        {
+            track_ids[g] = (*tr).next_id ++;
+            no_new ++;
+        }
+    }
+
+    /* breakup: previous track (group) and its children */
+    for(i = 0; i < no_ov; ++i)
+    {
+        order[3*i] = ov[3*i + 1];
+        order[3*i + 1] = track_ids[ov[3*i]];
+        order[3*i + 2] = 0;
+    }
+
+    if(no_ov > 1)
+    {
+        qsort(order, no_ov, 3 * sizeof(int), compareIntTriple);
+    }
+
+    sprintf(filename, "cpa_events%s.txt", suffix);
+    state = writeCpaEvents(filename, "breakup", order, no_ov, p_ids, p_children);
+
+    /* coalescence: cpa (group) and its parent tracks */
+    for(i = 0; i < no_ov; ++i)
+    {
+        ov[3*i + 1] = p_ids[ov[3*i + 1]];
+    }
+
+    if(state == STATE_OK)
+    {
+        state = writeCpaEvents(filename, "coalescence", ov, no_ov, track_ids, g_parents);
+    }
+
+    sprintf(filename, "cpa_tracks%s.txt", suffix);
+
+    if(state == STATE_OK)
+    {
+        state = printCpaTracks(filename, track_ids, n);
+    }
+
+    Message("Tracked %i global cpas: %i continued by overlap, %i by distance, "
+            "%i new.\n", n, no_continued, no_matched, no_new);
+
+    /* previous cpas of the next call, sorted by track id */
+    if((*tr).prev_track != NULL) free((*tr).prev_track);
+    if((*tr).prev_com != NULL) free((*tr).prev_com);
+    if((*tr).prev_vol != NULL) free((*tr).prev_vol);
+
+    (*tr).no_prev = 0;
+    (*tr).prev_track = (int*) malloc((n + 1) * sizeof(int));
+    (*tr).prev_com = (real*) malloc((ND_ND * n + 1) * sizeof(real));
+    (*tr).prev_vol = (real*) malloc((n + 1) * sizeof(real));
+    order = (int*) cpaArenaAlloc(a, (2 * n + 2) * sizeof(int));
+
+    if((*tr).prev_track == NULL || (*tr).prev_com == NULL || (*tr).prev_vol == NULL 
+        || order == NULL)
+    {
+        DebugMessage("Error (malloc): No free memory for previous cpas available!\n");
+        return STATE_ERROR;
+    }
+
+    for(g = 0; g < n; ++g)
+    {
+        order[2*g] = track_ids[g];
+        order[2*g + 1] = g;
+    }
+
+    qsort(order, n, 2 * sizeof(int), compareIntPair);
+
+    for(i = 0; i < n; ++i)
+    {
+        g = order[2*i + 1];
+        (*tr).prev_track[i] = track_ids[g];
+        (*tr).prev_vol[i] = (*GList).cpas[g].vol;
+
+        for(j = 0; j < ND_ND; ++j)
+        {
+            (*tr).prev_com[ND_ND*i + j] = (*GList).cpas[g].com[j];
+        }
+    }
+
+    (*tr).no_prev = n;
+
+    return state;
+}
+
+
+void cpaUpdateTrackCells(
+                        struct CpaTracker *tr,
+                        struct CpaList *DList,
+                        int *track_ids,
+                        int n
+                        )
+{
+/*
+    Keep the track ids of the global cpas per cell for the next call
+*/
+    int i, k, dci, t;
+    int *track = NULL;
+    struct Cpa *D = NULL;
+
+    for(i = 0; i < CPA_MAX_ZONES; ++i)
+    {
+        if((*tr).zones[i].track != NULL)
+        {
+            resetIntArray((*tr).zones[i].track, (*tr).zones[i].no_int_cells, -1);
+        }
+    }
+
+    for(k = 0; k < (*DList).no_cpas; ++k)
+    {
+        D = &((*DList).cpas[k]);
+        track = (*tr).zones[(*D).zone].track;
+
+        if(track == NULL || (*D).global_id < 0 || (*D).global_id >= n 
+            || (*D).cell_list == NULL)
+        {
+            continue;
+        }
+
+        t = track_ids[(*D).global_id];
+
+        for(dci = 0; dci < (*D).no_cells; ++dci)
+        {
+            track[(*D).cell_list[dci]] = t;
+        }
+    }
+}
+
+
+int cpaTrackCpas(
+                char suffix[],
+                struct CpaTracker *tr,
+                Domain *domain,
+                struct CpaList *DList,
+                struct CpaList *GList,
+                struct CpaArena *a
+                )
+{
+/*
+    Track the global cpas (collective, call after cpaGlobalCpas() on every 
+    compute node): the overlap triples are collected on node 0, the track 
+    ids of the global cpas are sent back and kept per cell for the next call
+*/
+    int state = STATE_OK;
+    int i;
+    int n = (*GList).no_cpas;
+    int no_ov = 0;
+    int *ov = NULL;
+    int *track_ids = NULL;
+    Thread *ct = NULL;
+    int exchange = STATE_OK;                /*node 0 could store all overlaps*/
+    #if RP_NODE
+    int no_recv;
+    int go, ok;
+    int *grown = NULL;
+    #endif
+
+    for(i = 0; i < cpa_config.no_fluid_ids && state == STATE_OK; ++i)
+    {
+        ct = Lookup_Thread(domain, cpa_config.fluid_ids[i]);
+
+        if(ct != NULL)
+        {
+            state = cpaTrackZoneCells(tr, i, ct);
+        }
+    }
+
+    if(state == STATE_OK)
+    {
+        state = cpaTrackOverlaps(tr, DList, &ov, &no_ov, a);
+    }
+
+    if(state != STATE_OK)
+    {
+        no_ov = 0;
+    }
+
+    /* on memory errors every compute node still runs the whole exchange: 
+       overlaps are only sent if node 0 can store them (go), n = -1 tells 
+       the compute nodes to keep their tracks, track ids are only sent to 
+       compute nodes which can store them (ok) */
+    #if RP_NODE
+    if(!I_AM_NODE_ZERO_P)
+    {
+        PRF_CSEND_INT(node_zero, &no_ov, 1, myid);
+        PRF_CRECV_INT(node_zero, &go, 1, node_zero);
+
+        if(go && no_ov > 0)
+        {
+            PRF_CSEND_INT(node_zero, ov, 3 * no_ov, myid);
+        }
+
+        PRF_CRECV_INT(node_zero, &n, 1, node_zero);
+
+        if(n < 0)
+        {
+            return STATE_ERROR;
+        }
+
+        track_ids = (int*) cpaArenaAlloc(a, (n + 1) * sizeof(int));
+        ok = (track_ids != NULL);
+        PRF_CSEND_INT(node_zero, &ok, 1, myid);
+
+        if(!ok)
+        {
+            DebugMessage("Error (arena): No free memory for track ids available!\n");
+            return STATE_ERROR;
+        }
+
+        if(n > 0)
+        {
+            PRF_CRECV_INT(node_zero, track_ids, n, node_zero);
+        }
+
+        cpaUpdateTrackCells(tr, DList, track_ids, n);
+
+        return state;
+    }
+
+    /* node 0: overlaps of all compute nodes */
+    compute_node_loop_not_zero(i)
+    {
+        PRF_CRECV_INT(i, &no_recv, 1, i);
+        go = 1;
+
+        if(no_recv > 0)
+        {
+            grown = (int*) cpaArenaGrow(a, ov, 3 * no_ov * sizeof(int), 
+                                        3 * (no_ov + no_recv) * sizeof(int));
+
+            if(grown == NULL)
+            {
+                DebugMessage("Error (arena): No free memory for track overlaps available!\n");
+                go = 0;
+                exchange = STATE_ERROR;
+            }
+            else
+            {
+                ov = grown;
+            }
+        }
+
+        PRF_CSEND_INT(i, &go, 1, myid);
+
+        if(go && no_recv > 0)
+        {
+            PRF_CRECV_INT(i, ov + 3 * no_ov, 3 * no_recv, i);
+            no_ov += no_recv;
+        }
+    }
+    #endif
+
+    if(exchange == STATE_OK)
+    {
+        track_ids = (int*) cpaArenaAlloc(a, (n + 1) * sizeof(int));
+
+        if(track_ids == NULL)
+        {
+            DebugMessage("Error (arena): No free memory for track ids available!\n");
+            exchange = STATE_ERROR;
+        }
+    }
+
+    if(exchange == STATE_OK)
+    {
+        resetIntArray(track_ids, n, -1);
+        state = cpaMatchTracks(suffix, tr, ov, no_ov, GList, track_ids, a);
+    }
+    else
+    {
+        n = -1;                             /* tracks are kept on all compute nodes */
+        state = STATE_ERROR;
+    }
+
+    #if RP_NODE
+    compute_node_loop_not_zero(i)
+    {
+        PRF_CSEND_INT(i, &n, 1, myid);
+
+        if(n >= 0)
+        {
+            PRF_CRECV_INT(i, &ok, 1, i);
+
+            if(ok && n > 0)
+            {
+                PRF_CSEND_INT(i, track_ids, n, myid);
+            }
+        }
+    }
+    #endif
+
+    if(n >= 0)
+    {
+        cpaUpdateTrackCells(tr, DList, track_ids, n);
+    }
+
+    return state;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/*
+Profile of a detection call: the stage timings and counters of every compute
+node (cpa_timings) are reduced to min / max / mean over all compute nodes and
+appended by node 0 as one line to cpa_profile.csv, together with the compute
+node with the longest detection time (e.g. the one holding a liquid sheet).
+*/
+
+#define CPA_PROFILE_METRICS 13
+
+static const char *cpa_profile_names[CPA_PROFILE_METRICS] = {
+    "counting_s", "adjacency_s", "labelling_s", "reduction_s", "stitching_s", 
+    "output_s", "total_s", "cells", "labelled_cells", "cpas", "nb_lookups", 
+    "boundary_updates", "arena_bytes"
+};
+
+
+void cpaPackTimings(struct CpaTimings *tm, real *v)
+{
+    v[0] = (*tm).counting;
+    v[1] = (*tm).adjacency;
+    v[2] = (*tm).labelling;
+    v[3] = (*tm).reduction;
+    v[4] = (*tm).stitching;
+    v[5] = (*tm).output;
+    v[6] = (*tm).total;
+    v[7] = (real) (*tm).no_cells;
+    v[8] = (real) (*tm).no_labelled_cells;
+    v[9] = (real) (*tm).no_cpas;
+    v[10] = (real) (*tm).no_nb_lookups;
+    v[11] = (real) (*tm).no_boundary_updates;
+    v[12] = (real) (*tm).arena_bytes;
+}
+
+
+int writeCpaProfile(
+                    char filename[],
+                    real *v_min,
+                    real *v_max,
+                    real *v_mean,
+                    int no_ranks,
+                    int slowest_rank
+                    )
+{
+    FILE *fd = NULL;
+    int state = STATE_OK;
+    int new_file = !cfileexists(filename);
+    int k;
+
+    fd = fopen(filename, "a");
+
+    if(fd == NULL)
+    {
+        Message("Error (writeCpaProfile()): Unable to open file %s "
+                "for writing!\n", filename);
+        return STATE_ERROR;
+    }
+
+    if(new_file)
+    {
+        fprintf(fd, "time,compute_nodes,slowest_node");
+
+        for(k = 0; k < CPA_PROFILE_METRICS; ++k)
+        {
+            fprintf(fd, ",%s_min,%s_max,%s_mean", cpa_profile_names[k], 
+                    cpa_profile_names[k], cpa_profile_names[k]);
+        }
+        fprintf(fd, "\n");
+    }
+
+    fprintf(fd, "%lf,%i,%i", CURRENT_TIME, no_ranks, slowest_rank);
+
+    for(k = 0; k < CPA_PROFILE_METRICS; ++k)
+    {
+        fprintf(fd, ",%lg,%lg,%lg", v_min[k], v_max[k], v_mean[k]);
+    }
+    fprintf(fd, "\n");
+
+    fclose(fd);
+
+    return state;
+}
+
+
+int cpaProfileReport()
+{
+/*
+    Reduce cpa_timings over all compute nodes (collective, has to be called
+    on every compute node) and write the profile line on node 0
+*/
+    real v_min[CPA_PROFILE_METRICS];
+    real v_max[CPA_PROFILE_METRICS];
+    real v_mean[CPA_PROFILE_METRICS];
+    int no_ranks = 1;
+    int slowest_rank = 0;
+    int k;
+    #if RP_NODE
+    real work[CPA_PROFILE_METRICS];
+    #endif
+
+    cpaPackTimings(&cpa_timings, v_min);
+
+    for(k = 0; k < CPA_PROFILE_METRICS; ++k)
+    {
+        v_max[k] = v_min[k];
+        v_mean[k] = v_min[k];
+    }
+
+    #if RP_NODE
+    no_ranks = compute_node_count;
+
+    PRF_GRLOW(v_min, CPA_PROFILE_METRICS, work);
+    PRF_GRHIGH(v_max, CPA_PROFILE_METRICS, work);
+    PRF_GRSUM(v_mean, CPA_PROFILE_METRICS, work);
+
+    /* lowest rank with the longest total time */
+    slowest_rank = PRF_GILOW1((cpa_timings.total >= v_max[6]) ? myid : no_ranks);
+
+    for(k = 0; k < CPA_PROFILE_METRICS; ++k)
+    {
+        v_mean[k] /= no_ranks;
+    }
+
+    if(!I_AM_NODE_ZERO_P)
+    {
+        return STATE_OK;
+    }
+    #endif
+
+    Message("Cpa detection %lf s (slowest compute node %i, mean %lf s), "
+            "labelling %lf s, reduction %lf s, stitching %lf s, output %lf s (max).\n",
+            v_max[6], slowest_rank, v_mean[6], v_max[2], v_max[3], v_max[4], v_max[5]);
+
+    return writeCpaProfile("cpa_profile.csv", v_min, v_max, v_mean, no_ranks, slowest_rank);
+}
+
+/*----------------------------------------------------------------------------*/
+
+/*
+Batch evaluation of data files (see example/cpad_batch.scm): the Scheme 
+driver reads one data file after the other into the loaded case and executes 
+CPAD_BATCH_oD after each file. The mesh does not change, so the cached 
+neighbor graph, boundary and partition interface cells are reused for all 
+files. The results of all files are appended to the usual result files (one 
+record per file) and indexed in cpa_batch.csv.
+*/
+
+static double cpa_batch_last_call = -1.0;   /* wall clock time of the last batch call */
+
+int writeCpaBatchIndex(char filename[])
+{
+/*
+    Append index, name (RP variables cpad/batch-index and cpad/batch-file), 
+    flow time, number of global cpas, detection time and total time since 
+    the previous file (incl. reading the data) of the current file on node 0
+*/
+    FILE *fd = NULL;
+    int new_file;
+    int index = -1;
+    char *name = "";
+    double now = cpaWallTime();
+    double file_time = (cpa_batch_last_call >= 0.0) ? now - cpa_batch_last_call : 0.0;
+
+    cpa_batch_last_call = now;
+
+    #if RP_NODE
+    if(!I_AM_NODE_ZERO_P)
+    {
+        return STATE_OK;
+    }
+    #endif
+
+    if(RP_Variable_Exists_P("cpad/batch-index"))
+    {
+        index = RP_Get_Integer("cpad/batch-index");
+    }
+
+    if(RP_Variable_Exists_P("cpad/batch-file"))
+    {
+        name = RP_Get_String("cpad/batch-file");
+    }
+
+    new_file = !cfileexists(filename);
+    fd = fopen(filename, "a");
+
+    if(fd == NULL)
+    {
+        Message("Error (writeCpaBatchIndex()): Unable to open file %s "
+                "for writing!\n", filename);
+        return STATE_ERROR;
+    }
+
+    if(new_file)
+    {
+        fprintf(fd, "index,file,time,global_cpas,detection_s,file_s\n");
+    }
+
+    fprintf(fd, "%i,%s,%lf,%i,%lg,%lg\n", index, name, CURRENT_TIME, 
+            cpa_timings.no_global_cpas, cpa_timings.total, file_time);
+
+    fclose(fd);
+
+    Message("Batch file %i (%s): %i global cpas, detection %lf s, file %lf s.\n", 
+            index, name, cpa_timings.no_global_cpas, cpa_timings.total, file_time);
+
+    return STATE_OK;
+}
+
+/*----------------------------------------------------------------------------*/
+
+void cpaWriteLabels(Domain *domain, struct CpaList *DList, int udm)
+{
+/*
+    Store the label of every interior cell in UDM udm for post processing 
+    (e.g. colour the cpas in CFD-Post / EnSight): the global id of its cpa 
+    + 1 (line in cpa_global, local cpa index + 1 without _STITCH), 0 for 
+    cells which are not part of a cpa. Uses the cell lists of the reduction,
+    so no per cell text output is necessary. Without cell lists 
+    (cpaFloodFillStats()) the UDM already holds the local cpa index + 1 of 
+    the fill, which is mapped to the global id.
+*/
+    int i, k, dci;
+    int filled = ((*DList).no_cpas > 0 && (*DList).cpas[0].cell_list == NULL);
+    real label;
+    cell_t c;
+    Thread *ct;
+    struct Cpa *D = NULL;
+
+    for(i = 0; i < cpa_config.no_fluid_ids; ++i)
+    {
+        ct = Lookup_Thread(domain, cpa_config.fluid_ids[i]);
+
+        if(ct != NULL)
+        {
+            begin_c_loop_int(c, ct)
+            {
+                k = filled ? (int) C_UDMI(c, ct, udm) - 1 : -1;
+
+                if(k >= 0 && k < (*DList).no_cpas)
+                {
+                    D = &((*DList).cpas[k]);
+                    C_UDMI(c, ct, udm) = (real) ((((*D).global_id >= 0) ? (*D).global_id : k) + 1);
+                }
+                else
+                {
+                    C_UDMI(c, ct, udm) = 0.0;
+                }
             }
-            else
-            {
-                Message("Error getCellsFaceNeighborCells(): Face index going to high!\n");
-            } 
+            end_c_loop_int(c, ct)
         }
     }
 
-    *cfncarr_size = i;
+    for(k = 0; k < (*DList).no_cpas; ++k)
+    {
+        D = &((*DList).cpas[k]);
+        ct = Lookup_Thread(domain, cpa_config.fluid_ids[(*D).zone]);
+        label = (real) ((((*D).global_id >= 0) ? (*D).global_id : k) + 1);
+
+        for(dci = 0; ct != NULL && (*D).cell_list != NULL && dci < (*D).no_cells; ++dci)
+        {
+            C_UDMI((*D).cell_list[dci], ct, udm) = label;
+        }
+    }
 }
 
+/*----------------------------------------------------------------------------*/
 
-void array1ElementFrequencyInArray2(int *arr1, int size1, int *arr2, int size2, int *freq_arr)
+int cpaGetRpIntList(char name[], int *list, int max_len)
 {
+/*
+    Read the integer list RP variable name into list, returns the list 
+    length or -1 if it is empty or longer than max_len
+*/
     int i;
+    int n = RP_Get_List_Length(name);
+
+    if(n < 1 || n > max_len)
+    {
+        return -1;
+    }
 
-    for(i=0; i<size1; ++i)
-    {   
-        freq_arr[i] = countValinIntArray(&(*arr2), size2, arr1[i]);
+    for(i = 0; i < n; ++i)
+    {
+        list[i] = RP_Get_List_Ref_Int(name, i);
     }
+
+    return n;
 }
 
-int countValinIntArray(int *arr, int arr_size, int val)
+
+int cpaCheckFluidZones(Domain *domain, int *ids, int n)
 {
-    int i;
-    int count = 0;
+/*
+    Returns n if the n ids are different fluid cell zones of domain, -1 
+    otherwise (face zones have no cells and no volume fractions)
+*/
+    int i, j;
+    Thread *t;
 
-    for(i=0; i<arr_size; ++i)
+    for(i = 0; i < n; ++i)
     {
-        if(arr[i] == val)
+        t = Lookup_Thread(domain, ids[i]);
+
+        if(t == NULL || !FLUID_THREAD_P(t))
+        {
+            return -1;
+        }
+
+        for(j = 0; j < i; ++j)
         {
-            count ++;
+            if(ids[j] == ids[i])
+            {
+                return -1;
+            }
         }
     }
 
-    return count;
+    return n;
 }
 
 
-int occursInCellArray(cell_t *arr, int arr_size, cell_t val)
+int cpaReadConfig(struct CpaConfig *cfg, Domain *domain)
 {
+/*
+    Settings of a detection call: the defaults (_PHASE_IDX, _MIN_VOL_FRAC, 
+    _CONNECTIVITY, _FLUID_) are overridden by the RP variables cpad/phases,
+    cpad/min-vol-frac, cpad/connectivity and cpad/fluid-zones if they are 
+    defined (see example/cpad_settings.scm). cpad/min-vol-fracs (list) 
+    replaces cpad/min-vol-frac by several limits detected in one pass, 
+    cpad/label-udm overrides _LABEL_UDM. They are read once per call, so
+    parameter studies only need (rpsetvar ...) between the calls instead of 
+    recompiling the library. Invalid values are reported and replaced by
+    the defaults.
+*/
+    int state = STATE_OK;
     int i;
+    int no_domain_phases = DOMAIN_N_DOMAINS(domain);
 
-    for(i=0; i<arr_size; ++i)
+    (*cfg).phases[0] = _PHASE_IDX;
+    (*cfg).no_phases = 1;
+    (*cfg).min_vol_frac = _MIN_VOL_FRAC;
+    (*cfg).connectivity = _CONNECTIVITY;
+    (*cfg).fluid_ids[0] = _FLUID_;
+    (*cfg).no_fluid_ids = 1;
+    (*cfg).label_udm = _LABEL_UDM;
+
+    if(RP_Variable_Exists_P("cpad/min-vol-frac"))
     {
-        if(arr[i] == val)
+        (*cfg).min_vol_frac = RP_Get_Real("cpad/min-vol-frac");
+
+        if((*cfg).min_vol_frac < 0.0 || (*cfg).min_vol_frac >= 1.0)
         {
-            return 1;
+            Message0("Error cpaReadConfig(): cpad/min-vol-frac %lf not in [0,1)!\n",
+                        (*cfg).min_vol_frac);
+            (*cfg).min_vol_frac = _MIN_VOL_FRAC;
+            state = STATE_ERROR;
         }
     }
 
-    return 0;
-}
-
-
-void getCellsEdgeNeighborCells(
-                                cell_t c0,
-                                Thread *c0t,
-                                cell_t nocells_c0t,  
-                                cell_t *cencarr,
-                                int *cfnarr_size,
-                                int *cencarr_size
-                                )
-{
-    int i,j;
-    cell_t ci;
-
-    *cencarr_size = 0;
+    (*cfg).min_vol_fracs[0] = (*cfg).min_vol_frac;
+    (*cfg).no_min_vol_fracs = 1;
 
-    cell_t c0_cfncarr[NO_MAX_CELL_FACE_NEIGHBOR_CELLS];
-    cell_t ci_cfncarr[NO_MAX_CELL_FACE_NEIGHBOR_CELLS];
-    int freq_c0_in_ci_cfncarr[NO_MAX_CELL_FACE_NEIGHBOR_CELLS];
-    int c0_cfncarr_size = 0;
-    int ci_cfncarr_size = 0;
+    if(RP_Variable_Exists_P("cpad/min-vol-fracs"))
+    {
+        (*cfg).no_min_vol_fracs = RP_Get_List_Length("cpad/min-vol-fracs");
 
-    getCellsFaceNeighborCells(c0, c0t, nocells_c0t, c0_cfncarr, &c0_cfncarr_size);
+        if((*cfg).no_min_vol_fracs > CPA_MAX_THRESHOLDS)
+        {
+            (*cfg).no_min_vol_fracs = -1;
+        }
 
-    for(i=0; i<c0_cfncarr_size; ++i)
-    {   
-        if(*cencarr_size < NO_MAX_CELL_EDGE_NEIGHBOR_CELLS)
+        for(i = 0; i < (*cfg).no_min_vol_fracs; ++i)
         {
-            cencarr[*cencarr_size] = c0_cfncarr[i];
-            *cencarr_size += 1;
+            (*cfg).min_vol_fracs[i] = RP_Get_List_Ref_Float("cpad/min-vol-fracs", i);
+
+            if((*cfg).min_vol_fracs[i] < 0.0 || (*cfg).min_vol_fracs[i] >= 1.0
+                || (i > 0 && (*cfg).min_vol_fracs[i] <= (*cfg).min_vol_fracs[i-1]))
+            {
+                (*cfg).no_min_vol_fracs = -1;
+            }
         }
-        else
+
+        if((*cfg).no_min_vol_fracs < 1)
         {
-            Message("Error getCellsEdgeNeighborCells(): Edge index going to high 1!\n");
+            Message0("Error cpaReadConfig(): cpad/min-vol-fracs has to be an ascending "
+                        "list of 1 to %i limits in [0,1)!\n", CPA_MAX_THRESHOLDS);
+            (*cfg).min_vol_fracs[0] = (*cfg).min_vol_frac;
+            (*cfg).no_min_vol_fracs = 1;
+            state = STATE_ERROR;
         }
+
+        (*cfg).min_vol_frac = (*cfg).min_vol_fracs[0];
     }
 
-    *cfnarr_size = c0_cfncarr_size;
+    if(RP_Variable_Exists_P("cpad/connectivity"))
+    {
+        (*cfg).connectivity = RP_Get_Integer("cpad/connectivity");
 
-    for(i=0; i<c0_cfncarr_size; ++i)
-    {   
-        ci = c0_cfncarr[i];
-        getCellsFaceNeighborCells(ci, c0t, nocells_c0t, ci_cfncarr, &ci_cfncarr_size);
+        if((*cfg).connectivity < CPA_CONNECT_FACE || (*cfg).connectivity > CPA_CONNECT_VERTEX)
+        {
+            Message0("Error cpaReadConfig(): cpad/connectivity %i is not 0 (face), "
+                        "1 (edge) or 2 (vertex)!\n", (*cfg).connectivity);
+            (*cfg).connectivity = _CONNECTIVITY;
+            state = STATE_ERROR;
+        }
+    }
 
-        array1ElementFrequencyInArray2(ci_cfncarr, ci_cfncarr_size, c0_cfncarr, c0_cfncarr_size, freq_c0_in_ci_cfncarr);
+    if(RP_Variable_Exists_P("cpad/phases"))
+    {
+        (*cfg).no_phases = cpaGetRpIntList("cpad/phases", (*cfg).phases, 
+                                            CPA_MAX_DETECT_PHASES);
 
-        for(j=0; j<ci_cfncarr_size; ++j)
+        for(i = 0; i < (*cfg).no_phases; ++i)
         {
-            if(freq_c0_in_ci_cfncarr[j] >= 2)
+            if((*cfg).phases[i] < 0 
+                || (no_domain_phases > 0 && (*cfg).phases[i] >= no_domain_phases))
             {
-                if(*cencarr_size < NO_MAX_CELL_EDGE_NEIGHBOR_CELLS)
-                {
-                    cencarr[*cencarr_size] = ci_cfncarr[j];
-                    *cencarr_size += 1;
-                }
-                else
-                {
-                    Message("Error getCellsEdgeNeighborCells(): Edge index going to high 2!\n");
-                }
+                (*cfg).no_phases = -1;
             }
         }
+
+        if((*cfg).no_phases < 1)
+        {
+            Message0("Error cpaReadConfig(): cpad/phases has to be a list of 1 to %i "
+                        "phase indices (0 ... %i)!\n", CPA_MAX_DETECT_PHASES, 
+                        no_domain_phases - 1);
+            (*cfg).phases[0] = _PHASE_IDX;
+            (*cfg).no_phases = 1;
+            state = STATE_ERROR;
+        }
     }
-}
 
+    if(RP_Variable_Exists_P("cpad/fluid-zones"))
+    {
+        (*cfg).no_fluid_ids = cpaGetRpIntList("cpad/fluid-zones", (*cfg).fluid_ids, 
+                                                CPA_MAX_ZONES);
+        (*cfg).no_fluid_ids = cpaCheckFluidZones(domain, (*cfg).fluid_ids, 
+                                                (*cfg).no_fluid_ids);
 
-face_t getGlobalFaceBetweenCells(cell_t c0, cell_t c1, Thread *ct)
-{
-    cell_t c0f, c1f;
-    face_t f;
-    Thread *tf;
-    int n;
+        if((*cfg).no_fluid_ids < 1)
+        {
+            Message0("Error cpaReadConfig(): cpad/fluid-zones has to be a list of 1 to "
+                        "%i different fluid cell zone ids, using %i!\n", CPA_MAX_ZONES,
+                        _FLUID_);
+            (*cfg).fluid_ids[0] = _FLUID_;
+            (*cfg).no_fluid_ids = 1;
+            state = STATE_ERROR;
+        }
+    }
 
-    c_face_loop(c0, ct, n)
+    if(cpaCheckFluidZones(domain, (*cfg).fluid_ids, (*cfg).no_fluid_ids) < 1)
     {
-        f = C_FACE(c0,ct,n);          
-        tf = C_FACE_THREAD(c0,ct,n);
+        Message0("Error cpaReadConfig(): _FLUID_ %i is not a fluid cell zone, no cpas "
+                    "are detected!\n", _FLUID_);
+        (*cfg).no_fluid_ids = 0;
+        state = STATE_ERROR;
+    }
 
-        if(tf != NULL)
-        {
-            c0f = F_C0(f, tf);
-            c1f= F_C1(f, tf);
+    if(RP_Variable_Exists_P("cpad/label-udm"))
+    {
+        (*cfg).label_udm = RP_Get_Integer("cpad/label-udm");
+    }
 
-            if ((c0f == c0 && c1f == c1) || (c0f == c1 && c1f == c0))
-            {
-                    return F_ID(f,tf);
-            }
-        }
+    /* one UDM per phase and limit */
+    if((*cfg).label_udm >= 0 
+        && (*cfg).label_udm + (*cfg).no_phases*(*cfg).no_min_vol_fracs > N_UDM)
+    {
+        Message0("Error cpaReadConfig(): cpad/label-udm %i needs %i UDMs, only %i "
+                    "allocated, no labels are written!\n", (*cfg).label_udm, 
+                    (*cfg).label_udm + (*cfg).no_phases*(*cfg).no_min_vol_fracs, N_UDM);
+        (*cfg).label_udm = -1;
+        state = STATE_ERROR;
     }
 
-    return -1;
+    return state;
 }
+
 /*----------------------------------------------------------------------------*/
 
+static int cpa_engine = _ENGINE;            /* labelling engine, see CPAD_*_oD */
+
 void cpa_detection()
 {
 /*
-    
+    Detect all cpas of the configured phases in the fluid zones with the 
+    selected labelling engine and append them to the cpa file of this 
+    compute node (one file per phase and limit if several phases / volume 
+    fraction limits are detected, several limits always use 
+    cpaUnionFindThresholds()), the global cpas are stitched and tracked
 */
     #if !RP_HOST
-    cell_t c, cx, ci;                 /*Cell index*/
     Domain *domain =Get_Domain(1);          /*Fluid domain*/
 
     int state = STATE_OK;
     Thread *ct;                             /*Cell Thread pointer*/
-    Thread *tf;                             /*Face Thread pointer*/
     Thread **pt;
-    face_t f, fid;
-    int fluid_IDs[] = {_FLUID_};                
-    real x_c[ND_ND];
-    real c_mass = 0;                               /*Local face index number*/
-    int i,j,n;
-    int cci;
-    struct Cpa D;                       /*Single Cpa*/
-    int dci;                                /*Cpa cell index*/	
-    int nocells_ct = 0;
+    int i, ip, k, ic;
+    int phase;
+    int no_limits;
+    struct CpaArena arena;                  /*Storage of all cpa lists*/
+    struct CpaList DLists[CPA_MAX_THRESHOLDS];  /*Cpa Lists per limit (dynamic allocation)*/
+    #if _STITCH
+    struct CpaList GList;                   /*Global cpas (node 0)*/
+    #endif
+    int first_cpa[CPA_MAX_THRESHOLDS];
+    struct CpaAdjacency *adj = NULL;        /*Cached neighbor graph of ct*/
+    int *nb_offset = NULL;
+    cell_t *nbs = NULL;
     int cell_count = 0;
-    int *cell_checked_arr = NULL;           /*0=unchecked, 1=checked*/
-    struct Cpa *DList = NULL;           /*Cpa List (dynamic allocation)*/
-    int i_DList = 0;                        /* Current Cpa index in Cpa list */
-    int DList_length = 0;                   /*Number Cpas in Cpa list */
-    int c0fnc_array_size;
-    char pbname[STRLENMAX];
-
-    #if _DETECT_OVER_EDGES
-    cell_t c0nc_array[NO_MAX_CELL_EDGE_NEIGHBOR_CELLS];  /*neighbor cells of c0*/
-    #else
-    cell_t c0nc_array[NO_MAX_CELL_FACE_NEIGHBOR_CELLS];
-    #endif    
+    char suffix[STRLENMAX];
+    char filename[100];
+    double t_start = cpaWallTime();
+    double t, reduction;
 
-    int c0nc_array_size = 0;
+    initCpaArena(&arena);
+    memset(&cpa_timings, 0, sizeof(cpa_timings));
 
-    int no_fluid_IDs = sizeof(fluid_IDs)/sizeof(fluid_IDs[0]);
-    
+    cpaReadConfig(&cpa_config, domain);
 
-    /* Count domain cells and initialize UDMI */
+    /* Count domain cells */
+    t = cpaWallTime();
     cell_count = 0;
-    for (i = 0; i < no_fluid_IDs; i++)
+    for (i = 0; i < cpa_config.no_fluid_ids; i++)
     {
         ct = NULL;
-        ct = Lookup_Thread(domain, fluid_IDs[i]);
+        ct = Lookup_Thread(domain, cpa_config.fluid_ids[i]);
 
         if(ct != NULL)
         {
@@ -794,353 +5906,265 @@ void cpa_detection()
         }
         else
         {
-            Message("Error CpaDetermination(): Cannot find fluid cell thread with id %i", fluid_IDs[i]);
+            Message("Error CpaDetermination(): Cannot find fluid cell thread with id %i", 
+                        cpa_config.fluid_ids[i]);
         }
-        
-    }
 
-    cell_checked_arr = (int*) calloc(cell_count,  sizeof(int));
-    
-    if(cell_checked_arr != NULL || cell_count == 0) 
-    {
-        Message("Found %i cells to check in myid: %i\n", cell_count, myid);
     }
-    else
-    {
-        DebugMessage("Error (calloc): No free memory for cell_checked_arr available!\n");
-        state = STATE_ERROR;
-    }
-    
-    if(state == STATE_OK &&  N_UDM >= MIN_UDMI)
-    {
-        for (i = 0; i < no_fluid_IDs; i++)
-        {
-            Message("Looking for Droplets in domain with id %i, myid %i\n", fluid_IDs[i], myid);
-
-            ct = NULL;
-            ct = Lookup_Thread(domain, fluid_IDs[i]);
-
-            if(ct != NULL)
-            {   
-                nocells_ct = THREAD_N_ELEMENTS_INT(ct);
-                nocells_ct += THREAD_N_ELEMENTS_EXT(ct);
-
-                begin_c_loop_int(c, ct)
-                {
-                    pt = THREAD_SUB_THREADS(ct);
-
-                    if(pt == NULL)
-                    {
-                        Message("Error pt == NULL!\n");
-                    }
-
-                    if(c >= cell_count)
-                    {
-                        Message("Error c > cell_count!\n");
-                    }
-
-                    /* find initial droplet cell */
-                    if (
-                        pt != NULL
-                        && (cell_checked_arr[c] != CELL_CHECKED) 
-                        && (C_VOF(c, pt[_PHASE_IDX]) > _MIN_VOL_FRAC)
-                        && (state == STATE_OK)
-                    )
-                    {
-                        state = initCpa(&D, c); /*Initital cpa (droplet)*/
-                        DList_length++;
-
-                        if (state == STATE_OK)
-                        {
-                            /* find connected droplet cells */
-                            for (dci = 0;  dci < D.no_cells; dci++)
-                            {
-                                cx = D.cell_list[dci];
 
-                                /* Update droplet properties */
-                                c_mass = C_VOF(cx, pt[_PHASE_IDX]) * C_VOLUME(cx, ct) 
-                                        * C_R(cx, pt[_PHASE_IDX]);
-                                D.mass += c_mass;
-                                D.vol += C_VOF(cx, pt[_PHASE_IDX]) * C_VOLUME(cx, ct);
-                                C_CENTROID(x_c, cx, ct);
+    cpa_timings.counting = cpaWallTime() - t;
+    Message("Found %i cells to check in myid: %i\n", cell_count, myid);
 
-                                D.alpha_mean = D.alpha_mean + C_VOF(cx, pt[_PHASE_IDX]);
-
-                                if(D.alpha_max < C_VOF(cx, pt[_PHASE_IDX]))
-                                {
-                                    D.alpha_max = C_VOF(cx, pt[_PHASE_IDX]);
-                                }
+    /* all compute nodes run the same phases and limits (collective stitching) */
+    for (ip = 0; ip < cpa_config.no_phases; ip++)
+    {
+        phase = cpa_config.phases[ip];
+        no_limits = cpa_config.no_min_vol_fracs;
 
-                                updateCpaWeights(&D, c_mass, x_c);
-                            
-                                c_face_loop(cx, ct, n)
-                                {
-                                    f = C_FACE(cx,ct,n); /*return thread global face index*/
-                                    tf = C_FACE_THREAD(cx,ct,n); 
-                                    
-                                    if(tf != NULL && BOUNDARY_FACE_THREAD_P(tf))
-                                    {
-                                        updateCpaBoundaryFaceID_List(&D, tf);
-                                    }
-                                }
+        for (k = 0; k < no_limits; k++)
+        {
+            initCpaList(&(DLists[k]));
+        }
 
-                                if (C_UDMI(cx,ct,0) > UDMI_INT_TOL) 
-                                {
-                                    /*Partition Boundary interior cell*/
-                                    /*add cell boundary id to boundary list ...
-                                    currently only working for cell neighbors accross
-                                    compute node boundaries ...*/
-                                    c0nc_array_size = 0;
-                                    getCellsFaceNeighborCells(cx, ct, nocells_ct, c0nc_array, &c0nc_array_size);
-
-                                    for(cci=0; cci<c0nc_array_size; ++cci)
-                                    {
-                                        ci = c0nc_array[cci];
-
-                                        if (C_PART(ci, ct) != myid && C_VOF(ci, pt[_PHASE_IDX]) > _MIN_VOL_FRAC)
-                                        {
-                                            fid = getGlobalFaceBetweenCells(cx, ci, ct);
-
-                                            if (fid != -1)
-                                            {
-                                                updateCpaParBoundaryFaceID_List(&D, fid);
-
-                                                sprintf(pbname, "procBoundary%ito%li", myid, (long) C_PART(ci, ct)); 
-                                                updateParBoundaryNameList(&D, pbname);
-                                            }
-                                        }
-                                    }
-                                }
+        for (i = 0; i < cpa_config.no_fluid_ids && state == STATE_OK; i++)
+        {
+            Message("Looking for Droplets of phase %i in domain with id %i, myid %i\n", 
+                        phase, cpa_config.fluid_ids[i], myid);
 
-                                c0nc_array_size = 0;
+            for (k = 0; k < no_limits; k++)
+            {
+                first_cpa[k] = DLists[k].no_cpas;
+            }
 
-                                #if _DETECT_OVER_EDGES
-                                getCellsEdgeNeighborCells(cx, ct, nocells_ct, c0nc_array, &c0nc_array_size, &c0fnc_array_size);
-                                #else
-                                getCellsFaceNeighborCells(cx, ct, nocells_ct, c0nc_array, &c0nc_array_size);
-                                #endif    
+            ct = NULL;
+            ct = Lookup_Thread(domain, cpa_config.fluid_ids[i]);
+            t = cpaWallTime();
+            adj = (ct != NULL) ? getCpaAdjacency(ct, cpa_config.connectivity) : NULL;
+            cpa_timings.adjacency += cpaWallTime() - t;
+            pt = (ct != NULL) ? THREAD_SUB_THREADS(ct) : NULL;
 
-                                for(cci=0; cci<c0nc_array_size; ++cci)
-                                {
-                                    ci = c0nc_array[cci];
-                                    pt = THREAD_SUB_THREADS(ct);
-
-                                    if( (cell_checked_arr[ci] != CELL_CHECKED)
-                                        && (C_PART(ci, ct) == myid)
-                                        && (C_VOF(ci, pt[_PHASE_IDX]) > _MIN_VOL_FRAC
-                                        && (ci != cx)
-                                        )
-                                    )
-                                    {
-                                        state = cpaCellsAppend(&D, ci);
-                                        setCellAsChecked(cell_checked_arr, cell_count, ci);
-                                    }
-                                    else
-                                    {
-                                        setCellAsChecked(cell_checked_arr, cell_count, ci);
-                                    }
-                                }
+            if(ct != NULL && adj != NULL && pt != NULL)
+            {
+                /* neighbor graph of the connectivity, selected once per call */
+                if(cpa_config.connectivity != CPA_CONNECT_FACE)
+                {
+                    nb_offset = (*adj).node_offset;
+                    nbs = (*adj).node_nbs;
+                }
+                else
+                {
+                    nb_offset = (*adj).face_offset;
+                    nbs = (*adj).face_nbs;
+                }
 
-                                setCellAsChecked(cell_checked_arr, cell_count, cx);
-                            }
+                t = cpaWallTime();
+                reduction = cpa_timings.reduction;
 
-                            D.alpha_mean = D.alpha_mean/D.no_cells;
+                if(no_limits > 1)
+                {
+                    state = cpaUnionFindThresholds(ct, pt[phase], adj, nb_offset, nbs,
+                                                    cpa_config.min_vol_fracs, no_limits,
+                                                    DLists, &arena);
+                }
+                else if(cpa_engine == CPA_ENGINE_INCREMENTAL)
+                {
+                    state = cpaIncremental(ct, pt[phase], phase, adj, nb_offset, nbs,
+                                            &(DLists[0]), &arena);
+                }
+                else if(cpa_engine == CPA_ENGINE_UNION_FIND)
+                {
+                    state = cpaUnionFind(domain, ct, pt[phase], adj, nb_offset, nbs,
+                                            &(DLists[0]), &arena);
+                }
+                else
+                {
+                    #if _STATS_ONLY
+                    state = cpaFloodFillStats(ct, pt[phase], adj, nb_offset, nbs,
+                                                &(DLists[0]), 
+                                                (cpa_config.label_udm >= 0) ? 
+                                                cpa_config.label_udm + ip*no_limits : -1,
+                                                &arena);
+                    #else
+                    state = cpaFloodFill(ct, pt[phase], adj, nb_offset, nbs,
+                                            &(DLists[0]), &arena);
+                    #endif
+                }
 
-                            setFinalCpaCOM(&D);
+                cpa_timings.labelling += cpaWallTime() - t 
+                                            - (cpa_timings.reduction - reduction);
 
-                            if(DList_length == 0)
-                            {
-                                DList = (struct Cpa*) calloc(DList_length, 
-                                                        sizeof(struct Cpa));
-                            }
-                            else
-                            {
-                                DList = (struct Cpa*) realloc(DList, 
-                                        (DList_length) * sizeof(struct Cpa));  
-                            }
-                                
-                            if(DList != NULL) 
-                            {
-                                state = copyCell_tArray(&(DList[i_DList].cell_list),
-                                            D.cell_list, D.no_cells);
-                                state = copyCell_tArray(&(DList[i_DList].parboundary_faces_list),
-                                            D.parboundary_faces_list, D.no_parboundary_faces);
-                                state = copyRealND_ND_Array(&(DList[i_DList].com), 
-                                            D.com, ND_ND);
-                                state = copyIntArray(&(DList[i_DList].boundary_id),
-                                            D.boundary_id, D.no_boundaries);
-                                state = copyCharArrays(&(DList[i_DList].parboundary_name_list),
-                                            D.parboundary_name_list, D.len_parboundary_name_list, STRLENMAX);
-
-                                DList[i_DList].no_boundaries = D.no_boundaries;       
-                                DList[i_DList].no_cells = D.no_cells;
-                                DList[i_DList].no_parboundary_faces = D.no_parboundary_faces;
-                                DList[i_DList].mass = D.mass;
-                                DList[i_DList].vol = D.vol;
-                                DList[i_DList].alpha_mean = D.alpha_mean;
-                                DList[i_DList].alpha_max = D.alpha_max;
-                                DList[i_DList].len_parboundary_name_list = D.len_parboundary_name_list;
-                            }
-                            else 
-                            {
-                                DebugMessage("Error (calloc/realloc): No free memory "
-                                                "for DList available!\n");
-                                state = STATE_ERROR;
-                            }
-                            i_DList ++;
-                            free(D.cell_list);
-                        }
-                        else
-                        {
-                            setCellAsChecked(cell_checked_arr, cell_count, c);
-                        }
+                for (k = 0; k < no_limits; k++)
+                {
+                    for (ic = first_cpa[k]; ic < DLists[k].no_cpas; ic++)
+                    {
+                        DLists[k].cpas[ic].zone = i;
                     }
-                }end_c_loop_int(c, ct)    
+                }
+            }
+            else if(ct != NULL && pt == NULL)
+            {
+                Message("Error pt == NULL!\n");
             }
             else
             {
-                Message("Error DropletDetermination(): Cannot find fluid cell thread with id %i", fluid_IDs[i]);
+                Message("Error DropletDetermination(): Cannot find fluid cell thread with id %i", 
+                            cpa_config.fluid_ids[i]);
             }
-        } 
-        Message("Found %i cpas in myid %i.\n", DList_length, myid);
-        printCpas("cpa.txt", DList, DList_length);
-        /*printCpaCells("cpa.txt", DList, DList_length, ct); */ /*For debug only*/
-    }
-    
-    /*Free Memory*/
-    if(DList_length > 0)
-    {
-        for(i=0; i<DList_length; ++i)
+        }
+
+        for (k = 0; k < no_limits; k++)
         {
-            if(DList[i].cell_list != NULL)
+            suffix[0] = '\0';
+
+            if(cpa_config.no_phases > 1)
             {
-                free(DList[i].cell_list);
+                sprintf(suffix, "_phase%i", phase);
             }
 
-            if(DList[i].parboundary_faces_list != NULL)
+            if(no_limits > 1)
             {
-                free(DList[i].parboundary_faces_list);
+                sprintf(suffix + strlen(suffix), "_vf%g", cpa_config.min_vol_fracs[k]);
+                Message("Found %i cpas of phase %i above %g in myid %i.\n", 
+                            DLists[k].no_cpas, phase, cpa_config.min_vol_fracs[k], myid);
             }
-
-            for(j=0;j<DList[i].len_parboundary_name_list;++j)
+            else
             {
-                if(DList[i].parboundary_name_list[j] != NULL)
-                {
-                    free(DList[i].parboundary_name_list[j]);
-                }
+                Message("Found %i cpas of phase %i in myid %i.\n", DLists[k].no_cpas, 
+                            phase, myid);
             }
-            
-            if(DList[i].parboundary_name_list != NULL)
+
+            t = cpaWallTime();
+            #if _STITCH
+            #if _OUTPUT == CPA_OUTPUT_BINARY
+            sprintf(filename, "cpa_global%s.bin", suffix);
+            #else
+            sprintf(filename, "cpa_global%s.txt", suffix);
+            #endif
+            initCpaList(&GList);
+            cpaGlobalCpas(filename, &(DLists[k]), &GList, &arena);  /*collective over all compute nodes*/
+            cpa_timings.no_global_cpas += GList.no_cpas;
+            #if _TRACK
+            cpaTrackCpas(suffix, getCpaTracker(ip, k, phase, cpa_config.min_vol_fracs[k]),
+                            domain, &(DLists[k]), &GList, &arena);  /*collective*/
+            #endif
+            #endif
+            cpa_timings.stitching += cpaWallTime() - t;
+
+            t = cpaWallTime();
+            #if _OUTPUT == CPA_OUTPUT_BINARY
+            sprintf(filename, "%i_cpa%s.bin", myid, suffix);
+            writeCpasBinary(filename, myid, DLists[k].cpas, DLists[k].no_cpas);
+            #else
+            sprintf(filename, "cpa%s.txt", suffix);
+            printCpas(filename, DLists[k].cpas, DLists[k].no_cpas);
+            #endif
+            /*printCpaCells("cpa.txt", DList.cpas, DList.no_cpas, ct); */ /*For debug only*/
+
+            if(cpa_config.label_udm >= 0)
             {
-                free(DList[i].parboundary_name_list);
-            } 
+                cpaWriteLabels(domain, &(DLists[k]), 
+                                cpa_config.label_udm + ip*no_limits + k);
+            }
+            cpa_timings.output += cpaWallTime() - t;
+
+            cpa_timings.no_cpas += DLists[k].no_cpas;
 
+            for (i = 0; i < DLists[k].no_cpas; i++)
+            {
+                cpa_timings.no_labelled_cells += DLists[k].cpas[i].no_cells;
+            }
         }
-        if(DList != NULL)
-        {
-            free(DList);
-        } 
-    }
-    if(cell_checked_arr != NULL) 
-    {
-        free(cell_checked_arr);
     }
 
+    cpa_timings.no_cells = cell_count;
+    cpa_timings.arena_bytes = cpaArenaBytes(&arena);
+
+    /*Free Memory*/
+    releaseCpaArena(&arena); /* DLists and all cpa lists at once */
+
+    cpa_timings.total = cpaWallTime() - t_start;
+
+    #if _PROFILE
+    cpaProfileReport();                     /*collective over all compute nodes*/
+    #endif
+
 #endif
 }
 
 /*----------------------------------------------------------------------------*/
 
+DEFINE_ON_DEMAND(CPAD_FLOOD_FILL_oD)    /* Select seed and grow labelling */
+{
+    cpa_engine = CPA_ENGINE_FLOOD_FILL;
+    Message0("Cpa detection uses flood fill labelling.\n");
+}
+
+
+DEFINE_ON_DEMAND(CPAD_UNION_FIND_oD)    /* Select disjoint set labelling */
+{
+    cpa_engine = CPA_ENGINE_UNION_FIND;
+    Message0("Cpa detection uses union find labelling.\n");
+}
+
+
+DEFINE_ON_DEMAND(CPAD_INCREMENTAL_oD)   /* Select incremental labelling */
+{
+    cpa_engine = CPA_ENGINE_INCREMENTAL;
+    Message0("Cpa detection uses incremental labelling.\n");
+}
+
+/*----------------------------------------------------------------------------*/
+
 DEFINE_ON_DEMAND(CPAD_oD)
 {
 #if !RP_HOST
     cpa_detection();
+    cpaWriterFlush();   /* results are complete when the command returns */
 #endif
 }
 
 
-DEFINE_EXECUTE_AT_END(CPAD_aE)
+DEFINE_ON_DEMAND(CPAD_BATCH_oD)    /* Detection of one data file of a batch run */
 {
 #if !RP_HOST
     cpa_detection();
+    cpaWriterFlush();
+    writeCpaBatchIndex("cpa_batch.csv");
 #endif
 }
 
 
-DEFINE_ON_DEMAND(MARKPAR_oD)
+DEFINE_EXECUTE_AT_END(CPAD_aE)
 {
 #if !RP_HOST
-    markParBoundCells();
+    cpa_detection();
 #endif
 }
 
 
-void markParBoundCells()
+DEFINE_EXECUTE_AT_EXIT(CPAD_aX)    /* Write pending results at the end of the session */
 {
+#if !RP_HOST
+    cpaWriterStop();
+#endif
+}
 
-    #if !RP_HOST
-    int n, nocells_ct;
-    cell_t c, c1, c0;                           /*Cell index*/
-    Domain *domain =Get_Domain(1);          /*Fluid domain*/
-    Thread *ct;                             /*Cell Thread pointer*/
-    Thread *tf;                             /*Face Thread pointer*/
-    face_t f;                               /*Face index*/        
-
-    if(N_UDM > 0)
-    {
-        thread_loop_c(ct, domain) /*loops over all cell threads in domain*/
-        {                        
-            if(ct != NULL)
-            {   
-                nocells_ct = THREAD_N_ELEMENTS_EEXT(ct);
-                nocells_ct += THREAD_N_ELEMENTS_INT(ct);
 
-                begin_c_loop_ext(c, ct)
-                {
-                    C_UDMI(c,ct,0) = 0.0;
-                }end_c_loop_ext(c, ct)
+DEFINE_ON_DEMAND(CPAD_RESET_oD)    /* Execute after mesh adaption / repartitioning */
+{
+#if !RP_HOST
+    invalidateCpaAdjacencyCache();
+    invalidateCpaLabelCache();
+    resetCpaTrackers(1);    /* keep the tracks, no cell overlap in the next call */
+#endif
+}
 
-                begin_c_loop_ext(c, ct)
-                {
-                    c_face_loop(c, ct, n)
-                    {
-                        f = C_FACE(c,ct,n);            /*return thread global face index*/
-                        tf = C_FACE_THREAD(c,ct,n);
 
-                        if(tf != NULL)
-                        {
-                            c0 = F_C0(f, tf);
-                            c1= F_C1(f, tf);
-                            
-                            if (c0 == c)
-                            {   
-                                if(c1> 0 && c1< nocells_ct)
-                                {
-                                    if(C_PART(c1,ct) == myid)
-                                    {   
-                                        C_UDMI(c1,ct,0) = myid+1;
-                                    }
-                                }
-                            }
-                            else if(c1 == c)
-                            {
-                                if(c0 > 0 && c0 < nocells_ct)
-                                {
-                                    if(C_PART(c0,ct) == myid)
-                                    {   
-                                        C_UDMI(c0,ct,0) = myid+1;
-                                    }
-                                }
-                            }	
-                        }
-                    }
-                }end_c_loop_ext(c, ct)
-            }
-        }
-    }
-    else
-    {
-        Message("Not enough UDMI Memory!\n");
-    }
-    #endif
+DEFINE_EXECUTE_AFTER_CASE(CPAD_aC, libname)
+{
+#if !RP_HOST
+    invalidateCpaAdjacencyCache();
+    invalidateCpaLabelCache();
+    resetCpaTrackers(0);
+#endif
 }